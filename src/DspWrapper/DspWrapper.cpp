@@ -23,7 +23,6 @@
 
 #include "DspWrapper.h"
 #include "entropictron.h"
-#include "DspFrameTimer.h"
 #include "DspWrapperNoise.h"
 #include "DspWrapperCrackle.h"
 #include "DspWrapperGlitch.h"
@@ -31,7 +30,6 @@
 #include "ent_state.h"
 
 DspWrapper::DspWrapper()
-        : frameTimer{std::make_unique<DspFrameTimer>()}
 {
         // Create DSP
         struct entropictron* dsp = nullptr;
@@ -71,16 +69,16 @@ DspWrapper::DspWrapper()
         // Rgate
         auto rgate = ent_get_rgate(entropictronDsp.get());
         dspRgate = std::make_unique<DspWrapperRgate>(rgate);
+}
 
-        // Set 50ms timeout.
-        frameTimer->setTimeout(getSampleRate() * 0.05);
+bool DspWrapper::prepare(unsigned int srate, size_t maxBlockSize)
+{
+        return ent_prepare(entropictronDsp.get(), srate, maxBlockSize) == ENT_OK;
 }
 
 void DspWrapper::setSampleRate(unsigned int srate)
 {
         ent_set_sample_rate(entropictronDsp.get(), srate);
-        // Set 50ms timeout.
-        frameTimer->setTimeout(srate * 0.05);
 }
 
 int DspWrapper::getSampleRate() const
@@ -91,6 +89,56 @@ int DspWrapper::getSampleRate() const
         return sampleRate;
 }
 
+void DspWrapper::allocateGlitchHistory()
+{
+        ent_alloc_glitch_history(entropictronDsp.get());
+}
+
+bool DspWrapper::isGlitchHistoryNeeded() const
+{
+        return ent_is_glitch_history_needed(entropictronDsp.get());
+}
+
+bool DspWrapper::setMemoryLock(bool lock)
+{
+        return ent_set_memory_lock(entropictronDsp.get(), lock) == ENT_OK;
+}
+
+bool DspWrapper::isMemoryLocked() const
+{
+        return ent_is_memory_locked(entropictronDsp.get());
+}
+
+void DspWrapper::prefaultMemory()
+{
+        ent_prefault_memory(entropictronDsp.get());
+}
+
+size_t DspWrapper::getMemorySize() const
+{
+        return ent_get_memory_size(entropictronDsp.get());
+}
+
+bool DspWrapper::setWorkerThreads(size_t count)
+{
+        return ent_set_worker_threads(entropictronDsp.get(), count) == ENT_OK;
+}
+
+size_t DspWrapper::getWorkerThreads() const
+{
+        return ent_get_worker_threads(entropictronDsp.get());
+}
+
+void DspWrapper::setOffline(bool offline)
+{
+        ent_set_offline(entropictronDsp.get(), offline);
+}
+
+bool DspWrapper::isOffline() const
+{
+        return ent_is_offline(entropictronDsp.get());
+}
+
 void DspWrapper::setState(const struct ent_state *state)
 {
         ent_set_state(entropictronDsp.get(), state);
@@ -137,14 +185,17 @@ double DspWrapper::getEntropy() const
         return ent_get_entropy(entropictronDsp.get());
 }
 
-void DspWrapper::updateEntropy()
+void DspWrapper::process(float** data, size_t size)
 {
-        ent_update_entropy(entropictronDsp.get());
+        ent_process(entropictronDsp.get(), data, size);
 }
 
-void DspWrapper::process(float** data, size_t size)
+void DspWrapper::process(float** data,
+                         size_t size,
+                         const struct ent_event *events,
+                         size_t count)
 {
-        ent_process(entropictronDsp.get(), data, size);
+        ent_process_events(entropictronDsp.get(), data, size, events, count);
 }
 
 void DspWrapper::pressKey(bool on, int pitch, int velocity)
@@ -180,10 +231,3 @@ DspWrapperRgate* DspWrapper::getRgate() const
 {
         return dspRgate.get();
 }
-
-DspFrameTimer* DspWrapper::getFrameTimer() const
-{
-        return frameTimer.get();
-}
-
-
@@ -34,18 +34,32 @@ class DspWrapperNoise;
 class DspWrapperCrackle;
 class DspWrapperGlitch;
 class DspWrapperRgate;
-class DspFrameTimer;
 struct ent_state;
 
 class DspWrapper
 {
 public:
         explicit DspWrapper();
+        bool prepare(unsigned int srate, size_t maxBlockSize);
         void setSampleRate(unsigned int srate);
         int getSampleRate() const;
+        void allocateGlitchHistory();
+        bool isGlitchHistoryNeeded() const;
+        bool setMemoryLock(bool lock);
+        bool isMemoryLocked() const;
+        void prefaultMemory();
+        size_t getMemorySize() const;
+        bool setWorkerThreads(size_t count);
+        size_t getWorkerThreads() const;
+        void setOffline(bool offline);
+        bool isOffline() const;
         void setState(const struct ent_state *state);
         void getState(struct ent_state *state) const;
         void process(float** data, size_t size);
+        void process(float** data,
+                     size_t size,
+                     const struct ent_event *events,
+                     size_t count);
         void pressKey(bool on = true,
                       int pitch = Entropictron::defaultMidiKey,
                       int velocity = Entropictron::maxKeyVelocity);
@@ -56,12 +70,10 @@ public:
         void setEntropyDepth(double depth);
         double getEntropyDepth() const;
         double getEntropy() const;
-        void updateEntropy();
         DspWrapperNoise* getNoise(NoiseId id) const;
         DspWrapperCrackle* getCrackle(CrackleId id) const;
         DspWrapperGlitch* getGlitch(GlitchId id) const;
         DspWrapperRgate* getRgate() const;
-        DspFrameTimer* getFrameTimer() const;
 
 protected:
 
@@ -73,7 +85,6 @@ private:
                 }
         };
 
-        std::unique_ptr<DspFrameTimer> frameTimer;
         std::unique_ptr<struct entropictron, DspDeleter> entropictronDsp;
         std::unique_ptr<DspWrapperNoise> dspNoise1;
         std::unique_ptr<DspWrapperNoise> dspNoise2;
@@ -111,3 +111,33 @@ double DspWrapperGlitch::wet() const
     return ent_glitch_get_wet(glitchDsp);
 }
 
+void DspWrapperGlitch::setCrossfade(double value)
+{
+    ent_glitch_set_crossfade(glitchDsp, value);
+}
+
+double DspWrapperGlitch::crossfade() const
+{
+    return ent_glitch_get_crossfade(glitchDsp);
+}
+
+void DspWrapperGlitch::setSpeed(double value)
+{
+    ent_glitch_set_speed(glitchDsp, value);
+}
+
+double DspWrapperGlitch::speed() const
+{
+    return ent_glitch_get_speed(glitchDsp);
+}
+
+void DspWrapperGlitch::setInterpolation(int value)
+{
+    ent_glitch_set_interpolation(glitchDsp, static_cast<enum ent_glitch_interpolation>(value));
+}
+
+int DspWrapperGlitch::interpolation() const
+{
+    return ent_glitch_get_interpolation(glitchDsp);
+}
+
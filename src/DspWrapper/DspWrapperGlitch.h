@@ -48,6 +48,12 @@ public:
     double dry() const;
     void setWet(double value);
     double wet() const;
+    void setCrossfade(double value);
+    double crossfade() const;
+    void setSpeed(double value);
+    double speed() const;
+    void setInterpolation(int value);
+    int interpolation() const;
 
 private:
     struct ent_glitch* glitchDsp;
@@ -0,0 +1,155 @@
+/**
+ * File name: EventMerger.h
+ * Project: Entropictron (A texture synthesizer)
+ *
+ * Copyright (C) 2025 Iurie Nistor
+ *
+ * This file is part of Entropictron.
+ *
+ * Entropictron is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef ENT_EVENT_MERGER_H
+#define ENT_EVENT_MERGER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Merges in offset order the events of sources already sorted by
+ * offset, like the event list and the parameter queues of a host
+ * block, without copying or sorting them. The next event of each
+ * source is kept in a fixed size min-heap, nothing is allocated.
+ * The events with equal offsets are taken in the source order.
+ */
+template <size_t MaxSources>
+class EventMerger
+{
+public:
+        struct Cursor {
+                int32_t offset;
+                int32_t source;
+                int32_t index;
+        };
+
+        void clear()
+        {
+                heapSize = 0;
+        }
+
+        /**
+         * Adds the event at index of the source, the source must not
+         * be in the merge. Returns false if MaxSources are merged.
+         */
+        bool push(int32_t source, int32_t index, int32_t offset)
+        {
+                if (heapSize == MaxSources)
+                        return false;
+
+                const Node node = {key(offset, source), index};
+                size_t i = heapSize++;
+                while (i > 0) {
+                        size_t parent = (i - 1) / 2;
+                        if (heap[parent].key <= node.key)
+                                break;
+                        heap[i] = heap[parent];
+                        i = parent;
+                }
+                heap[i] = node;
+                return true;
+        }
+
+        bool empty() const
+        {
+                return heapSize == 0;
+        }
+
+        size_t size() const
+        {
+                return heapSize;
+        }
+
+        /**
+         * Returns the next event in the offset order.
+         */
+        Cursor top() const
+        {
+                const Node &node = heap[0];
+                return {static_cast<int32_t>(static_cast<uint32_t>(node.key >> 32) ^ 0x80000000u),
+                        static_cast<int32_t>(static_cast<uint32_t>(node.key)),
+                        node.index};
+        }
+
+        /**
+         * Replaces the top event with the next event of its source.
+         */
+        void next(int32_t index, int32_t offset)
+        {
+                const int32_t source = static_cast<int32_t>(static_cast<uint32_t>(heap[0].key));
+                siftDown({key(offset, source), index});
+        }
+
+        /**
+         * Removes the top event, when its source has no events left.
+         */
+        void pop()
+        {
+                if (--heapSize > 0)
+                        siftDown(heap[heapSize]);
+        }
+
+private:
+        /**
+         * The offset and the source packed in a key, ordered by offset
+         * and then by source, compared in a single comparison.
+         */
+        struct Node {
+                uint64_t key;
+                int32_t index;
+        };
+
+        static uint64_t key(int32_t offset, int32_t source)
+        {
+                return (static_cast<uint64_t>(static_cast<uint32_t>(offset) ^ 0x80000000u) << 32)
+                        | static_cast<uint32_t>(source);
+        }
+
+        /**
+         * Places the node at the top and moves it down to its place,
+         * moving the smaller children up.
+         */
+        void siftDown(const Node node)
+        {
+                size_t i = 0;
+                for (;;) {
+                        size_t child = 2 * i + 1;
+                        if (child >= heapSize)
+                                break;
+                        if (child + 1 < heapSize && heap[child + 1].key < heap[child].key)
+                                child++;
+                        if (node.key <= heap[child].key)
+                                break;
+                        heap[i] = heap[child];
+                        i = child;
+                }
+                heap[i] = node;
+        }
+
+        std::array<Node, MaxSources> heap;
+        size_t heapSize = 0;
+};
+
+#endif // ENT_EVENT_MERGER_H
@@ -72,6 +72,7 @@ void EntState::getState(struct ent_state* state) const
                 ent_state_crackle_set_brightness(cs, crackle[i].brightness);
                 ent_state_crackle_set_envelope_shape(cs, crackle[i].envelope_shape);
                 ent_state_crackle_set_stereo_spread(cs, crackle[i].stereo_spread);
+                ent_state_crackle_set_voices(cs, crackle[i].voices);
 
                 // Glitch
                 auto gs = ent_state_get_glitch(state, i);
@@ -83,6 +84,9 @@ void EntState::getState(struct ent_state* state) const
                 ent_state_glitch_set_repeats(gs, glitch[i].repeats);
                 ent_state_glitch_set_dry(gs, glitch[i].dry);
                 ent_state_glitch_set_wet(gs, glitch[i].wet);
+                ent_state_glitch_set_crossfade(gs, glitch[i].crossfade);
+                ent_state_glitch_set_speed(gs, glitch[i].speed);
+                ent_state_glitch_set_interpolation(gs, glitch[i].interpolation);
         }
 
         auto rg = ent_state_get_rgate(state);
@@ -126,6 +130,7 @@ void EntState::setState(const struct ent_state* state)
                 crackle[i].brightness = ent_state_crackle_get_brightness(cs);
                 crackle[i].envelope_shape = ent_state_crackle_get_envelope_shape(cs);
                 crackle[i].stereo_spread = ent_state_crackle_get_stereo_spread(cs);
+                crackle[i].voices = ent_state_crackle_get_voices(cs);
 
                 // Glitch
                 const auto* gs = ent_state_get_glitch_const(state, i);
@@ -137,6 +142,9 @@ void EntState::setState(const struct ent_state* state)
                 glitch[i].repeats = ent_state_glitch_get_repeats(gs);
                 glitch[i].dry = ent_state_glitch_get_dry(gs);
                 glitch[i].wet = ent_state_glitch_get_wet(gs);
+                glitch[i].crossfade = ent_state_glitch_get_crossfade(gs);
+                glitch[i].speed = ent_state_glitch_get_speed(gs);
+                glitch[i].interpolation = ent_state_glitch_get_interpolation(gs);
         }
 
         const auto* rg = ent_state_get_rgate_const(state);
@@ -384,6 +392,7 @@ void EntState::writeCrackle(Value& modulesArray,
                 m.AddMember("brightness", crackle[i].brightness, a);
                 m.AddMember("duration", crackle[i].duration, a);
                 m.AddMember("stereo", crackle[i].stereo_spread, a);
+                m.AddMember("voices", crackle[i].voices, a);
                 modulesArray.PushBack(m, a);
         }
 }
@@ -403,6 +412,9 @@ void EntState::writeGlitch(Value& modulesArray,
                 m.AddMember("max_jump", glitch[i].max_jump, a);
                 m.AddMember("dry", glitch[i].dry, a);
                 m.AddMember("wet", glitch[i].wet, a);
+                m.AddMember("crossfade", glitch[i].crossfade, a);
+                m.AddMember("speed", glitch[i].speed, a);
+                m.AddMember("interpolation", glitch[i].interpolation, a);
                 modulesArray.PushBack(m, a);
         }
 }
@@ -472,6 +484,9 @@ void EntState::readCrackle(const Value& m, size_t id)
                 crackle[id].duration = m["duration"].GetDouble();
         if (m.HasMember("stereo") && m["stereo"].IsNumber())
                 crackle[id].stereo_spread = m["stereo"].GetDouble();
+        if (m.HasMember("voices") && m["voices"].IsInt())
+                crackle[id].voices =
+                        std::clamp(m["voices"].GetInt(), 1, ENT_CRACKLE_MAX_VOICES);
 }
 
 void EntState::readGlitch(const Value& m, size_t id)
@@ -495,6 +510,13 @@ void EntState::readGlitch(const Value& m, size_t id)
                 glitch[id].dry = m["dry"].GetDouble();
         if (m.HasMember("wet") && m["wet"].IsNumber())
                 glitch[id].wet = m["wet"].GetDouble();
+        if (m.HasMember("crossfade") && m["crossfade"].IsNumber())
+                glitch[id].crossfade = m["crossfade"].GetDouble();
+        if (m.HasMember("speed") && m["speed"].IsNumber())
+                glitch[id].speed = m["speed"].GetDouble();
+        if (m.HasMember("interpolation") && m["interpolation"].IsInt())
+                glitch[id].interpolation =
+                        std::clamp(m["interpolation"].GetInt(), 0, ENT_GLITCH_INTERP_NUM_TYPES - 1);
 }
 
 void EntState::readRgate(const Value& m)
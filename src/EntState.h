@@ -57,6 +57,7 @@ class EntState
                 double brightness = 0.0;
                 double duration = 0.0;
                 double stereo_spread = 0.0;
+                int voices = ENT_CRACKLE_DEFAULT_VOICES;
         };
 
         struct Glitch {
@@ -69,6 +70,9 @@ class EntState
                 double max_jump = 0.0;
                 double dry = 0.0;
                 double wet = 0.0;
+                double crossfade = ENT_GLITCH_DEFAULT_CROSSFADE;
+                double speed = ENT_GLITCH_DEFAULT_SPEED;
+                int interpolation = ENT_GLITCH_DEFAULT_INTERP;
         };
 
         struct Rgate {
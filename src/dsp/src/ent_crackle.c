@@ -30,6 +30,55 @@
 #include "ent_state_internal.h"
 
 #include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+// Maximum number of silent samples between bursts.
+#define ENT_CRACKLE_MAX_GAP ((size_t)INT32_MAX)
+
+// Level below which the filter state is flushed to zero.
+#define ENT_CRACKLE_SILENCE 1e-10f
+
+// The brightness shelf, the stored brightness is inverted.
+static const struct ent_shelf_curve ent_crackle_shelf_curve = {
+        .min_cutoff = 4000.0f,
+        .max_cutoff = 8000.0f,
+        .min_gain = 24.0f,
+        .max_gain = 1.0f,
+        .normalize = false
+};
+
+// Number of segments of the envelope tables.
+#define ENT_CRACKLE_ENV_TABLE_SIZE 256
+
+enum ent_crackle_env_tables_state {
+        ENT_CRACKLE_ENV_TABLES_NONE     = 0,
+        ENT_CRACKLE_ENV_TABLES_BUILDING = 1,
+        ENT_CRACKLE_ENV_TABLES_READY    = 2
+};
+
+/**
+ * The burst envelopes sampled over the burst duration, built once and
+ * shared read-only by all instances. Each table has an extra point at
+ * the end for the interpolation.
+ */
+static float ent_crackle_env_tables[ENT_CRACKLE_ENV_NUM_TYPES][ENT_CRACKLE_ENV_TABLE_SIZE + 1];
+static atomic_int ent_crackle_env_tables_state = ENT_CRACKLE_ENV_TABLES_NONE;
+
+/**
+ * The playing bursts in struct-of-arrays form, the active
+ * bursts are kept packed in [0, count).
+ */
+struct ent_crackle_bursts {
+        float amplitude[ENT_CRACKLE_MAX_VOICES];
+        float gain_l[ENT_CRACKLE_MAX_VOICES];
+        float gain_r[ENT_CRACKLE_MAX_VOICES];
+        // Envelope table position increment per burst sample.
+        float step[ENT_CRACKLE_MAX_VOICES];
+        uint32_t index[ENT_CRACKLE_MAX_VOICES];
+        uint32_t samples[ENT_CRACKLE_MAX_VOICES];
+        size_t count;
+};
 
 struct ent_crackle {
         // Parameters
@@ -42,8 +91,9 @@ struct ent_crackle {
         enum ent_crackle_envelope envelope_shape;
         float stereo_spread;
 
+        int voices;
+
         int sample_rate;
-        int sample_channel;
         struct qx_randomizer prob_randomizer;
         struct qx_randomizer randomizer;
         struct qx_randomizer burst_width_randomizer;
@@ -51,19 +101,87 @@ struct ent_crackle {
         struct qx_fader fader;
         struct ent_shelf_filter sh_filter_l;
         struct ent_shelf_filter sh_filter_r;
-        float buffer[2][4096];
-        size_t burst_index;
-        size_t burst_samples;
-        float burst_amplitude;
+        // Samples left before the next burst starts.
+        size_t burst_countdown;
+        bool schedule_burst;
+        struct ent_crackle_bursts bursts;
 };
 
-struct ent_crackle* ent_crackle_create(int sample_rate)
+/**
+ * Returns the burst envelope at the position t of the burst [0, 1].
+ * Used only to build the envelope tables, a new shape needs only a
+ * case here.
+ */
+static float ent_crackle_envelope(enum ent_crackle_envelope shape, float t)
 {
-        struct ent_crackle* c = calloc(1, sizeof(struct ent_crackle));
-        if (!c)
-                return NULL;
+        switch(shape) {
+        case ENT_CRACKLE_ENV_EXPONENTIAL:
+        {
+                float decay = 10.0f;
+                float denom = 1.0f - expf(-decay);
+                if (fabsf(denom) < 1e-6f)
+                        denom = 1e-6f;
+
+                return (expf(-decay * t) - expf(-decay)) / denom;
+        }
+        case ENT_CRACKLE_ENV_LINEAR:
+                return 1.0f - t;
+        case ENT_CRACKLE_ENV_TRIANGLE:
+                return 1.0f - fabsf(2.0f * t - 1.0f);
+        default:
+                return 0.0f;
+        }
+}
+
+static void ent_crackle_init_env_tables(void)
+{
+        int state = ENT_CRACKLE_ENV_TABLES_NONE;
+        if (atomic_compare_exchange_strong(&ent_crackle_env_tables_state,
+                                           &state,
+                                           ENT_CRACKLE_ENV_TABLES_BUILDING)) {
+                for (size_t shape = 0; shape < ENT_CRACKLE_ENV_NUM_TYPES; shape++) {
+                        for (size_t i = 0; i <= ENT_CRACKLE_ENV_TABLE_SIZE; i++) {
+                                float t = (float)i / ENT_CRACKLE_ENV_TABLE_SIZE;
+                                ent_crackle_env_tables[shape][i] = ent_crackle_envelope(shape, t);
+                        }
+                }
+                atomic_store_explicit(&ent_crackle_env_tables_state,
+                                      ENT_CRACKLE_ENV_TABLES_READY,
+                                      memory_order_release);
+                return;
+        }
 
-        qx_randomizer_init(&c->prob_randomizer, -1.0f, 1.0f, 1.0f / 65536.0f);
+        // Wait if another instance is building the tables.
+        while (atomic_load_explicit(&ent_crackle_env_tables_state, memory_order_acquire)
+               != ENT_CRACKLE_ENV_TABLES_READY)
+                ;
+}
+
+/**
+ * Returns the envelope at the table position pos [0, table size).
+ */
+static inline float ent_crackle_env_lookup(const float *table, float pos)
+{
+        size_t index = (size_t)pos;
+        float frac = pos - (float)index;
+        return table[index] + frac * (table[index + 1] - table[index]);
+}
+
+size_t ent_crackle_size(void)
+{
+        return sizeof(struct ent_crackle);
+}
+
+struct ent_crackle* ent_crackle_init(void *mem, int sample_rate)
+{
+        struct ent_crackle* c = mem;
+        memset(c, 0, sizeof(struct ent_crackle));
+        ent_crackle_init_env_tables();
+
+        // Uniform values in (0, 1] for the silent gaps between the bursts.
+        qx_randomizer_init(&c->prob_randomizer,
+                           1.0f / 16777216.0f, 1.0f,
+                           1.0f / 16777216.0f);
         qx_randomizer_init(&c->randomizer, -1.0f, 1.0f, 1.0f / 65536.0f);
         qx_randomizer_init(&c->stereo_randomizer, 0.0f, 1.0f, 1.0f / 65536.0f);
         qx_randomizer_init(&c->burst_width_randomizer, 0.0f, 1.0f, 1.0f / 65536.0f);
@@ -72,24 +190,33 @@ struct ent_crackle* ent_crackle_create(int sample_rate)
         c->enabled = false;
         c->rate = 20.0f;
         c->duration = 1.0f;
-        c->burst_samples = (c->duration / 1000.0f) * c->sample_rate;
         c->amplitude = 1.0f;
         c->randomness = 1.0f;
         c->brightness = 0.5f;
         c->envelope_shape = ENT_CRACKLE_ENV_EXPONENTIAL;
         c->stereo_spread = 0.0f;
-        c->sample_channel = 0;
-        c->burst_index = 0;
-        c->burst_amplitude = 0.0f;
+        c->voices = ENT_CRACKLE_DEFAULT_VOICES;
+        c->burst_countdown = 0;
+        c->schedule_burst = true;
 
         qx_fader_init(&c->fader, 50, c->sample_rate);
 
+        ent_crackle_prepare(c->sample_rate);
         ent_shelf_filter_init(&c->sh_filter_l, c->sample_rate, 4000.0f, 1.0f);
         ent_shelf_filter_init(&c->sh_filter_r, c->sample_rate, 4000.0f, 1.0f);
 
         return c;
 }
 
+struct ent_crackle* ent_crackle_create(int sample_rate)
+{
+        struct ent_crackle* c = malloc(sizeof(struct ent_crackle));
+        if (!c)
+                return NULL;
+
+        return ent_crackle_init(c, sample_rate);
+}
+
 void ent_crackle_free(struct ent_crackle **c)
 {
         if (c && *c) {
@@ -98,6 +225,32 @@ void ent_crackle_free(struct ent_crackle **c)
         }
 }
 
+static void ent_crackle_update_brightness(struct ent_crackle *c)
+{
+        ent_shelf_filter_set_brightness(&c->sh_filter_l,
+                                        &ent_crackle_shelf_curve,
+                                        c->sample_rate,
+                                        c->brightness);
+        ent_shelf_filter_set_brightness(&c->sh_filter_r,
+                                        &ent_crackle_shelf_curve,
+                                        c->sample_rate,
+                                        c->brightness);
+}
+
+void ent_crackle_prepare(int sample_rate)
+{
+        ent_shelf_filter_prepare(&ent_crackle_shelf_curve, sample_rate);
+}
+
+void ent_crackle_set_sample_rate(struct ent_crackle *c, int sample_rate)
+{
+        c->sample_rate = sample_rate;
+        c->bursts.count = 0;
+        c->schedule_burst = true;
+        qx_fader_set_time(&c->fader, 50, c->sample_rate);
+        ent_crackle_update_brightness(c);
+}
+
 enum ent_error ent_crackle_enable(struct ent_crackle *c, bool b)
 {
         c->enabled = b;
@@ -113,6 +266,7 @@ bool ent_crackle_is_enabled(const struct ent_crackle *c)
 enum ent_error ent_crackle_set_rate(struct ent_crackle *c, float rate)
 {
         c->rate = qx_clamp_float(rate, 0.5f, 150.0f);
+        c->schedule_burst = true;
         return ENT_OK;
 }
 
@@ -157,18 +311,7 @@ float ent_crackle_get_randomness(const struct ent_crackle *c)
 enum ent_error ent_crackle_set_brightness(struct ent_crackle *c, float brightness)
 {
         c->brightness = 1.0 - qx_clamp_float(brightness, 0.0f, 1.0f);
-
-        float min_cutoff = 4000.0f;
-        float max_cutoff = 8000.0f;
-        float cutoff = min_cutoff + (max_cutoff - min_cutoff) * c->brightness;
-
-        float min_gain = 1.0f;
-        float max_gain = 24.0f;
-        float gain = min_gain + (max_gain - min_gain) *  brightness;
-
-        ent_shelf_filter_set_cutoff(&c->sh_filter_l, c->sample_rate, cutoff, gain);
-        ent_shelf_filter_set_cutoff(&c->sh_filter_r, c->sample_rate, cutoff, gain);
-
+        ent_crackle_update_brightness(c);
         return ENT_OK;
 }
 
@@ -201,93 +344,211 @@ float ent_crackle_get_stereo_spread(const struct ent_crackle *c)
         return c->stereo_spread;
 }
 
-void ent_crackle_process(struct ent_crackle *c, float **data, size_t size)
+enum ent_error ent_crackle_set_voices(struct ent_crackle *c, int voices)
 {
-        float val = 0.0f;
-        for (size_t i = 0; i < size; i++) {
-                 if (c->burst_index > 0) {
-                        // Apply envelope
-                        float t = (float)c->burst_index / c->burst_samples;
-                        switch(c->envelope_shape) {
-                        case ENT_CRACKLE_ENV_EXPONENTIAL:
-                        {
-                                float decay = 10.0f;
-                                float denom = 1.0f - expf(-decay);
-                                if (fabsf(denom) < 1e-6f)
-                                        denom = 1e-6f;
-
-                                float env = (expf(-decay * t) - expf(-decay)) / denom;
-                                val = c->burst_amplitude * env;
-                                break;
-                        }
-                        case ENT_CRACKLE_ENV_LINEAR:
-                                val = c->burst_amplitude * (1.0f - t);
-                                break;
-                        case ENT_CRACKLE_ENV_TRIANGLE:
-                                val = c->burst_amplitude * (1.0f - fabsf(2.0f * t - 1.0f));
-                                break;
-                        default:
-                                val = 0.0f;
-                                break;
-                        }
+        if (voices < 1)
+                voices = 1;
+        else if (voices > ENT_CRACKLE_MAX_VOICES)
+                voices = ENT_CRACKLE_MAX_VOICES;
+        c->voices = voices;
+        return ENT_OK;
+}
 
-                        c->burst_index++;
-                        if (c->burst_index >= c->burst_samples)
-                                c->burst_index = 0;
-                } else {
-                        float sparse_prob = fabs(qx_randomizer_get_float(&c->prob_randomizer));
-                        if (sparse_prob <= c->rate / c->sample_rate) {
-                                c->burst_index = 1; // first sample of burst
-
-                                // Calculate random burst amplitude.
-                                float rand_val = qx_randomizer_get_float(&c->randomizer);
-                                float ampl_sign = rand_val >= 0 ? 1.0f : -1.0f;
-                                float amp_random = 1.0f - fabs(rand_val) * c->randomness;
-                                c->burst_amplitude = ampl_sign * amp_random * c->amplitude;
-
-                                // Calculate random burst width.
-                                rand_val = qx_randomizer_get_float(&c->burst_width_randomizer);
-                                float rad_duration = 0.1f + (c->duration - 0.1f) * (1.0 - rand_val * c->randomness);
-                                c->burst_samples = (rad_duration / 1000.0f) * c->sample_rate;
-
-                                // Calculate random stereo channel
-                                rand_val = fabs(qx_randomizer_get_float(&c->stereo_randomizer));
-                                float width = c->stereo_spread / 2.0f;
-                                if (rand_val < width)
-                                        c->sample_channel = 1; // left channel
-                                else if (rand_val > 1.0f - width)
-                                        c->sample_channel = 2; // right channel
-                                else
-                                        c->sample_channel = 0; // both channel
-                        } else {
-                                c->burst_index = 0; // first sample of burst
-                                c->burst_amplitude = 0.0;
-                        }
+int ent_crackle_get_voices(const struct ent_crackle *c)
+{
+        return c->voices;
+}
 
-                        // apply first sample of burst
-                        val *= c->burst_amplitude;
+/**
+ * Draws the number of samples before the next burst. A burst starts
+ * at each sample with the probability rate / sample rate, so the gap
+ * is geometrically distributed and drawn once per burst.
+ */
+static size_t ent_crackle_draw_gap(struct ent_crackle *c)
+{
+        const float p = c->rate / c->sample_rate;
+        if (p <= 0.0f)
+                return ENT_CRACKLE_MAX_GAP;
+        else if (p >= 1.0f)
+                return 0;
+
+        const float u = qx_randomizer_get_float(&c->prob_randomizer);
+        const float gap = logf(u) / log1pf(-p);
+        if (gap < (float)ENT_CRACKLE_MAX_GAP)
+                return (size_t)gap;
+        return ENT_CRACKLE_MAX_GAP;
+}
+
+static void ent_crackle_start_burst(struct ent_crackle *c)
+{
+        struct ent_crackle_bursts *bursts = &c->bursts;
+        if (bursts->count >= (size_t)c->voices)
+                return; // All voices are playing, the burst is dropped.
+
+        const size_t v = bursts->count++;
+
+        // Calculate random burst amplitude.
+        float rand_val = qx_randomizer_get_float(&c->randomizer);
+        float ampl_sign = rand_val >= 0 ? 1.0f : -1.0f;
+        float amp_random = 1.0f - fabs(rand_val) * c->randomness;
+        bursts->amplitude[v] = ampl_sign * amp_random * c->amplitude;
+
+        // Calculate random burst width.
+        rand_val = qx_randomizer_get_float(&c->burst_width_randomizer);
+        float rad_duration = 0.1f + (c->duration - 0.1f) * (1.0 - rand_val * c->randomness);
+        uint32_t samples = (rad_duration / 1000.0f) * c->sample_rate;
+        if (samples < 2)
+                samples = 2;
+        bursts->samples[v] = samples;
+        bursts->index[v] = 1; // first sample of burst
+        bursts->step[v] = (float)ENT_CRACKLE_ENV_TABLE_SIZE / samples;
+
+        // Calculate random stereo channel
+        rand_val = fabs(qx_randomizer_get_float(&c->stereo_randomizer));
+        float width = c->stereo_spread / 2.0f;
+        bursts->gain_l[v] = 1.0f;
+        bursts->gain_r[v] = 1.0f;
+        if (rand_val < width)
+                bursts->gain_r[v] = 0.0f; // left channel
+        else if (rand_val > 1.0f - width)
+                bursts->gain_l[v] = 0.0f; // right channel
+}
+
+static void ent_crackle_remove_burst(struct ent_crackle_bursts *bursts, size_t v)
+{
+        const size_t last = --bursts->count;
+        bursts->amplitude[v] = bursts->amplitude[last];
+        bursts->gain_l[v] = bursts->gain_l[last];
+        bursts->gain_r[v] = bursts->gain_r[last];
+        bursts->step[v] = bursts->step[last];
+        bursts->index[v] = bursts->index[last];
+        bursts->samples[v] = bursts->samples[last];
+}
+
+/**
+ * Adds the next n samples of the playing bursts to the buffers,
+ * the bursts that end are removed.
+ */
+static void ent_crackle_render_bursts(struct ent_crackle_bursts *bursts,
+                                      const float *env_table,
+                                      float *buf_l,
+                                      float *buf_r,
+                                      size_t n)
+{
+        size_t v = 0;
+        while (v < bursts->count) {
+                const uint32_t index = bursts->index[v];
+                size_t len = bursts->samples[v] - index;
+                if (len > n)
+                        len = n;
+
+                const float amplitude = bursts->amplitude[v];
+                const float step = bursts->step[v];
+                const float gain_l = bursts->gain_l[v];
+                const float gain_r = bursts->gain_r[v];
+                for (size_t i = 0; i < len; i++) {
+                        float pos = (float)(index + i) * step;
+                        float val = amplitude * ent_crackle_env_lookup(env_table, pos);
+                        buf_l[i] += val * gain_l;
+                        buf_r[i] += val * gain_r;
                 }
 
-                val = qx_fader_fade(&c->fader, val);
-
-                if (c->sample_channel == 1) {
-                        c->buffer[0][i] = val;
-                        c->buffer[1][i] = 0.0f;
-                } else if (c->sample_channel == 2) {
-                        c->buffer[0][i] = 0.0f;
-                        c->buffer[1][i] = val;
-                } else {
-                        c->buffer[0][i] = val;
-                        c->buffer[1][i] = val;
+                bursts->index[v] += len;
+                if (bursts->index[v] >= bursts->samples[v])
+                        ent_crackle_remove_burst(bursts, v);
+                else
+                        v++;
+        }
+}
+
+/**
+ * Renders the bursts to the buffers. The blocks without bursts
+ * are skipped without per-sample work.
+ *
+ * Returns false if the block is silent.
+ */
+static bool ent_crackle_render(struct ent_crackle *c,
+                               float *buf_l,
+                               float *buf_r,
+                               size_t size)
+{
+        if (c->schedule_burst) {
+                c->burst_countdown = ent_crackle_draw_gap(c);
+                c->schedule_burst = false;
+        }
+
+        if (c->bursts.count == 0 && c->burst_countdown >= size) {
+                c->burst_countdown -= size;
+                qx_fader_skip(&c->fader, size);
+                return false;
+        }
+
+        const float *env_table = ent_crackle_env_tables[c->envelope_shape];
+        memset(buf_l, 0, size * sizeof(float));
+        memset(buf_r, 0, size * sizeof(float));
+
+        size_t i = 0;
+        while (i < size) {
+                size_t n = size - i;
+                if (n > c->burst_countdown)
+                        n = c->burst_countdown;
+
+                ent_crackle_render_bursts(&c->bursts, env_table, buf_l + i, buf_r + i, n);
+                c->burst_countdown -= n;
+                i += n;
+
+                if (i < size) {
+                        ent_crackle_start_burst(c);
+                        c->burst_countdown = 1 + ent_crackle_draw_gap(c);
                 }
         }
 
-        ent_shelf_filter_process(&c->sh_filter_l, c->buffer[0], size);
-        ent_shelf_filter_process(&c->sh_filter_r, c->buffer[1], size);
+        for (size_t i = 0; i < size; i++) {
+                buf_l[i] = qx_fader_fade(&c->fader, buf_l[i]);
+                buf_r[i] *= c->fader.fade;
+        }
+
+        return true;
+}
+
+static bool ent_crackle_filter_is_silent(struct ent_shelf_filter *filter)
+{
+        if (fabsf(filter->z1) < ENT_CRACKLE_SILENCE && fabsf(filter->z2) < ENT_CRACKLE_SILENCE) {
+                filter->z1 = 0.0f;
+                filter->z2 = 0.0f;
+                return true;
+        }
+
+        return false;
+}
+
+void ent_crackle_process(struct ent_crackle *c,
+                         float **data,
+                         float **scratch,
+                         size_t size)
+{
+        float *buf_l = scratch[0];
+        float *buf_r = scratch[1];
+
+        bool active = ent_crackle_render(c, buf_l, buf_r, size);
+
+        if (!active) {
+                // Nothing to add if the filter tail is over too.
+                bool silent_l = ent_crackle_filter_is_silent(&c->sh_filter_l);
+                bool silent_r = ent_crackle_filter_is_silent(&c->sh_filter_r);
+                if (silent_l && silent_r)
+                        return;
+
+                memset(buf_l, 0, size * sizeof(float));
+                memset(buf_r, 0, size * sizeof(float));
+        }
+
+        ent_shelf_filter_process(&c->sh_filter_l, buf_l, size);
+        ent_shelf_filter_process(&c->sh_filter_r, buf_r, size);
 
         for (size_t i = 0; i < size; i++) {
-                data[0][i] += c->buffer[0][i];
-                data[1][i] += c->buffer[1][i];
+                data[0][i] += buf_l[i];
+                data[1][i] += buf_r[i];
         }
 }
 
@@ -301,6 +562,7 @@ void ent_crackle_set_state(struct ent_crackle *c, const struct ent_state_crackle
         ENT_SET_STATE(c, state, brightness,     ent_crackle_set_brightness);
         ENT_SET_STATE(c, state, envelope_shape, ent_crackle_set_envelope_shape);
         ENT_SET_STATE(c, state, stereo_spread,  ent_crackle_set_stereo_spread);
+        ENT_SET_STATE(c, state, voices,         ent_crackle_set_voices);
 }
 
 void ent_crackle_get_state(const struct ent_crackle *c, struct ent_state_crackle *state)
@@ -313,4 +575,5 @@ void ent_crackle_get_state(const struct ent_crackle *c, struct ent_state_crackle
         ENT_GET_STATE(c, state, brightness,     ent_crackle_get_brightness);
         ENT_GET_STATE(c, state, envelope_shape, ent_crackle_get_envelope_shape);
         ENT_GET_STATE(c, state, stereo_spread,  ent_crackle_get_stereo_spread);
+        ENT_GET_STATE(c, state, voices,         ent_crackle_get_voices);
 }
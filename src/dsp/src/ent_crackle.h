@@ -30,6 +30,10 @@
 extern "C" {
 #endif
 
+// Maximum number of overlapping bursts.
+#define ENT_CRACKLE_MAX_VOICES 16
+#define ENT_CRACKLE_DEFAULT_VOICES 1
+
 enum ent_crackle_envelope {
     ENT_CRACKLE_ENV_EXPONENTIAL = 0,
     ENT_CRACKLE_ENV_LINEAR,
@@ -42,8 +46,28 @@ struct ent_state_crackle;
 
 struct ent_crackle* ent_crackle_create(int sample_rate);
 
+/**
+ * Returns the size of the module, used to place it in memory
+ * provided by the caller with ent_crackle_init().
+ */
+size_t ent_crackle_size(void);
+
+struct ent_crackle* ent_crackle_init(void *mem, int sample_rate);
+
 void ent_crackle_free(struct ent_crackle **c);
 
+/**
+ * Prepares the data shared by the crackle modules for the sample rate.
+ * Not real-time safe, called before the rate is applied.
+ */
+void ent_crackle_prepare(int sample_rate);
+
+/**
+ * Updates the sample rate dependent state. Doesn't allocate,
+ * can be called from the audio thread.
+ */
+void ent_crackle_set_sample_rate(struct ent_crackle *c, int sample_rate);
+
 enum ent_error ent_crackle_enable(struct ent_crackle *c, bool b);
 
 bool ent_crackle_is_enabled(const struct ent_crackle *c);
@@ -77,7 +101,23 @@ enum ent_error ent_crackle_set_stereo_spread(struct ent_crackle *c, float spread
 
 float ent_crackle_get_stereo_spread(const struct ent_crackle *c);
 
-void ent_crackle_process(struct ent_crackle *c, float **data, size_t size);
+/**
+ * Sets the maximum number of bursts playing at the same time,
+ * [1, ENT_CRACKLE_MAX_VOICES]. A burst starting while all voices
+ * are playing is dropped.
+ */
+enum ent_error ent_crackle_set_voices(struct ent_crackle *c, int voices);
+
+int ent_crackle_get_voices(const struct ent_crackle *c);
+
+/**
+ * Adds the crackle to data. The scratch buffers (two channels) are
+ * used as working memory and must hold at least size frames.
+ */
+void ent_crackle_process(struct ent_crackle *c,
+                         float **data,
+                         float **scratch,
+                         size_t size);
 
 void ent_crackle_set_state(struct ent_crackle *c, const struct ent_state_crackle *state);
 
@@ -32,6 +32,13 @@ extern "C" {
 
 #define ENT_UNUSED(expr) (void)expr
 
+// For processing kernels specialized by constant arguments.
+#if defined(__GNUC__) || defined(__clang__)
+#define ENT_ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+#define ENT_ALWAYS_INLINE inline
+#endif
+
 #define ENT_DEFAULT_SAMPLE_RATE 48000
 
 #define ENT_MAX_KEY_VELOCITY 127
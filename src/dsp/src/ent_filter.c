@@ -26,6 +26,7 @@
 #include "ent_filter.h"
 #include "ent_log.h"
 #include "qx_math.h"
+#include "qx_fastmath.h"
 
 static inline float q_max_from_cutoff(float Qmin,
                                       float Qmax,
@@ -37,19 +38,24 @@ static inline float q_max_from_cutoff(float Qmin,
         if (C >= fs * 0.5f)
                 return Qmin;
 
-        float k = 5.0f;
+        const float k = 5.0f;
         float c = C / (fs * 0.5f);
-        float exp_k = expf(-k);
+        // Constant, folded at compile time.
+        const float exp_k = expf(-k);
         float denom = 1.0f - exp_k;
-        float num   = expf(-k * c) - exp_k;
+        float num   = qx_fast_expf(-k * c) - exp_k;
         float Q = Qmin + (Qmax - Qmin) * (num / denom);
 
         return qx_clamp_float(Q, Qmin, Qmax);
 }
 
+/**
+ * Computes the target coefficients of the cutoff and resonance.
+ */
 static void ent_filter_update_coeffs(struct ent_filter* filter)
 {
         filter->isnan_val = false;
+        filter->update = false;
 
         float Qmin = 0.1f;
         float Qmax = 5.0f;
@@ -59,9 +65,20 @@ static void ent_filter_update_coeffs(struct ent_filter* filter)
                                     filter->sample_rate);
 
         float fc = qx_clamp_float(filter->cutoff, 20.0f, 0.49f * filter->sample_rate);
-        filter->g = tanf((float)M_PI * fc / filter->sample_rate);
-        filter->k = 1.0f / Q;
-        filter->denom = 1.0f + filter->g * (filter->g + filter->k);
+        filter->g_target = qx_fast_tanf((float)M_PI * fc / filter->sample_rate);
+        filter->k_target = 1.0f / Q;
+}
+
+/**
+ * Sets the coefficients to their targets, without interpolation.
+ */
+static void ent_filter_jump_coeffs(struct ent_filter* filter)
+{
+        filter->g = filter->g_target;
+        filter->k = filter->k_target;
+        filter->g_step = 0.0f;
+        filter->k_step = 0.0f;
+        filter->inv_denom = 1.0f / (1.0f + filter->g * (filter->g + filter->k));
 }
 
 void ent_filter_init(struct ent_filter* filter,
@@ -81,6 +98,15 @@ void ent_filter_init(struct ent_filter* filter,
         filter->ic2eq[0] = filter->ic2eq[1] = 0.0f;
 
         ent_filter_update_coeffs(filter);
+        ent_filter_jump_coeffs(filter);
+}
+
+void ent_filter_set_sample_rate(struct ent_filter* filter,
+                                float sample_rate)
+{
+        filter->sample_rate = sample_rate;
+        ent_filter_update_coeffs(filter);
+        ent_filter_jump_coeffs(filter);
 }
 
 void ent_filter_set_type(struct ent_filter* filter,
@@ -97,8 +123,10 @@ enum ent_filter_type ent_filter_get_type(const struct ent_filter* filter)
 void ent_filter_set_cutoff(struct ent_filter* filter,
                            float cut_off)
 {
-        filter->cutoff = cut_off;
-        ent_filter_update_coeffs(filter);
+        if (filter->cutoff != cut_off) {
+                filter->cutoff = cut_off;
+                filter->update = true;
+        }
 }
 
 float ent_filter_get_cutoff(const struct ent_filter* filter)
@@ -109,8 +137,10 @@ float ent_filter_get_cutoff(const struct ent_filter* filter)
 void ent_filter_set_resonance(struct ent_filter* filter,
                               float resonance)
 {
-        filter->resonance = resonance;
-        ent_filter_update_coeffs(filter);
+        if (filter->resonance != resonance) {
+                filter->resonance = resonance;
+                filter->update = true;
+        }
 }
 
 float ent_filter_get_resonance(const struct ent_filter* filter)
@@ -118,71 +148,53 @@ float ent_filter_get_resonance(const struct ent_filter* filter)
         return filter->resonance;
 }
 
-void ent_filter_process(struct ent_filter* filter,
-                        float **data,
-                        size_t size)
+bool ent_filter_ramp(struct ent_filter* filter, size_t size)
 {
-        if (filter->type == ENT_FILTER_TYPE_ALLPASS)
-                return;
+        ent_filter_jump_coeffs(filter);
+        if (!filter->update || size == 0)
+                return false;
 
-        const float g = filter->g;
-        const float k = filter->k;
-        const float denom = filter->denom;
+        ent_filter_update_coeffs(filter);
+        filter->g_step = (filter->g_target - filter->g) / (float)size;
+        filter->k_step = (filter->k_target - filter->k) / (float)size;
+        return filter->g_step != 0.0f || filter->k_step != 0.0f;
+}
 
+static ENT_ALWAYS_INLINE void
+ent_filter_process_type(struct ent_filter* filter,
+                        enum ent_filter_type type,
+                        bool ramp,
+                        float **data,
+                        size_t size)
+{
         float *L = data[0];
         float *R = data[1];
-
         for (size_t i = 0; i < size; i++) {
-                /* Left channel */
-                {
-                        float v0 = L[i];
-
-                        float v1 = (v0 - k * filter->ic1eq[0] - filter->ic2eq[0]) / denom;
-                        float v2 = filter->ic1eq[0] + g * v1;
-                        float v3 = filter->ic2eq[0] + g * v2;
-
-                        filter->ic1eq[0] = 2.0f * v2 - filter->ic1eq[0];
-                        filter->ic2eq[0] = 2.0f * v3 - filter->ic2eq[0];
-
-                        switch (filter->type) {
-                        case ENT_FILTER_TYPE_LOWPASS:  L[i] = v3;
-                                break;
-                        case ENT_FILTER_TYPE_BANDPASS: L[i] = v2;
-                                break;
-                        case ENT_FILTER_TYPE_HIGHPASS: L[i] = v0 - k * v2 - v3;
-                                break;
-                        default: L[i] = v3;
-                                break;
-                        }
-                }
-
-                /* Right channel */
-                {
-                        float v0 = R[i];
-
-                        float v1 = (v0 - k * filter->ic1eq[1] - filter->ic2eq[1]) / denom;
-                        float v2 = filter->ic1eq[1] + g * v1;
-                        float v3 = filter->ic2eq[1] + g * v2;
-
-                        filter->ic1eq[1] = 2.0f * v2 - filter->ic1eq[1];
-                        filter->ic2eq[1] = 2.0f * v3 - filter->ic2eq[1];
-
-                        switch (filter->type) {
-                        case ENT_FILTER_TYPE_LOWPASS:  R[i] = v3;
-                                break;
-                        case ENT_FILTER_TYPE_BANDPASS: R[i] = v2;
-                                break;
-                        case ENT_FILTER_TYPE_HIGHPASS: R[i] = v0 - k * v2 - v3;
-                                break;
-                        default: R[i] = v3;
-                                break;
-                        }
-                }
+                if (ramp)
+                        ent_filter_next_coeffs(filter);
+                L[i] = qx_clamp_float(ent_filter_process_sample(filter, type, 0, L[i]),
+                                      -1.0f, 1.0f);
+                R[i] = qx_clamp_float(ent_filter_process_sample(filter, type, 1, R[i]),
+                                      -1.0f, 1.0f);
         }
+}
 
-        for (size_t i = 0; i < size; i++) {
-                L[i] = qx_clamp_float(L[i], -1.0f, 1.0f);
-                R[i] = qx_clamp_float(R[i], -1.0f, 1.0f);
+void ent_filter_process(struct ent_filter* filter,
+                        float **data,
+                        size_t size)
+{
+        const bool ramp = ent_filter_ramp(filter, size);
+        switch (filter->type) {
+        case ENT_FILTER_TYPE_LOWPASS:
+                ent_filter_process_type(filter, ENT_FILTER_TYPE_LOWPASS, ramp, data, size);
+                break;
+        case ENT_FILTER_TYPE_BANDPASS:
+                ent_filter_process_type(filter, ENT_FILTER_TYPE_BANDPASS, ramp, data, size);
+                break;
+        case ENT_FILTER_TYPE_HIGHPASS:
+                ent_filter_process_type(filter, ENT_FILTER_TYPE_HIGHPASS, ramp, data, size);
+                break;
+        default: // allpass
+                break;
         }
 }
-
@@ -26,6 +26,10 @@
 
 #include "ent_defs.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 enum ent_filter_type {
         ENT_FILTER_TYPE_ALLPASS,
         ENT_FILTER_TYPE_LOWPASS,
@@ -42,7 +46,15 @@ struct ent_filter {
         float ic2eq[2];
         float g;
         float k;
-        float denom;
+        float inv_denom;
+        // Coefficients of the cutoff and resonance, reached per
+        // sample over the block prepared by ent_filter_ramp().
+        float g_target;
+        float k_target;
+        float g_step;
+        float k_step;
+        // The cutoff or the resonance changed since the last ramp.
+        bool update;
         bool isnan_val;
 };
 
@@ -51,6 +63,9 @@ void ent_filter_init(struct ent_filter* filter,
                      float cut_off,
                      float gain);
 
+void ent_filter_set_sample_rate(struct ent_filter* filter,
+                                float sample_rate);
+
 void ent_filter_set_type(struct ent_filter* filter,
                          enum ent_filter_type type);
 
@@ -66,8 +81,76 @@ void ent_filter_set_resonance(struct ent_filter* filter,
 
 float ent_filter_get_resonance(const struct ent_filter* filter);
 
+/**
+ * Prepares the coefficients for the next block of the given size. The
+ * previous ramp is completed and, if the cutoff or the resonance changed,
+ * the coefficients are recomputed and interpolated per sample towards
+ * the new ones over the block. Must be called before each block
+ * processed with ent_filter_process_sample(), ent_filter_process() calls
+ * it itself. Returns false if the coefficients are constant over the
+ * block, then the ramp doesn't need to be advanced.
+ */
+bool ent_filter_ramp(struct ent_filter* filter, size_t size);
+
 void ent_filter_process(struct ent_filter* filter,
                         float **data,
                         size_t size);
 
+/**
+ * Advances the coefficients ramp by one sample, called once per sample
+ * before processing the channels.
+ */
+static ENT_ALWAYS_INLINE void
+ent_filter_next_coeffs(struct ent_filter* filter)
+{
+        filter->g += filter->g_step;
+        filter->k += filter->k_step;
+        filter->inv_denom = 1.0f / (1.0f + filter->g * (filter->g + filter->k));
+}
+
+/**
+ * Advances the coefficients ramp by the given number of samples that
+ * are not processed.
+ */
+static inline void
+ent_filter_skip_coeffs(struct ent_filter* filter, size_t n)
+{
+        filter->g += (float)n * filter->g_step;
+        filter->k += (float)n * filter->k_step;
+        filter->inv_denom = 1.0f / (1.0f + filter->g * (filter->g + filter->k));
+}
+
+/**
+ * Processes one sample of the given channel, for fused processing
+ * loops. The type is passed by the caller to be a constant, the
+ * output is not clamped. The type must not be allpass.
+ */
+static ENT_ALWAYS_INLINE float
+ent_filter_process_sample(struct ent_filter* filter,
+                          enum ent_filter_type type,
+                          size_t channel,
+                          float v0)
+{
+        const float k = filter->k;
+        const float g = filter->g;
+        float v1 = (v0 - k * filter->ic1eq[channel] - filter->ic2eq[channel]) * filter->inv_denom;
+        float v2 = filter->ic1eq[channel] + g * v1;
+        float v3 = filter->ic2eq[channel] + g * v2;
+
+        filter->ic1eq[channel] = 2.0f * v2 - filter->ic1eq[channel];
+        filter->ic2eq[channel] = 2.0f * v3 - filter->ic2eq[channel];
+
+        switch (type) {
+        case ENT_FILTER_TYPE_BANDPASS:
+                return v2;
+        case ENT_FILTER_TYPE_HIGHPASS:
+                return v0 - k * v2 - v3;
+        default: // low-pass
+                return v3;
+        }
+}
+
+#ifdef __cplusplus
+}
+#endif
 #endif // ENT_FILTER_H
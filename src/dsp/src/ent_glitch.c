@@ -22,12 +22,38 @@
  */
 
 #include "ent_glitch.h"
+#include "ent_history.h"
 #include "ent_log.h"
 #include "qx_math.h"
 #include "qx_randomizer.h"
 #include "ent_state_internal.h"
 
+#include <stdatomic.h>
 #include <stdlib.h>
+#include <string.h>
+
+// The longest fade in samples, 20 ms at 192 kHz.
+#define ENT_GLITCH_MAX_CROSSFADE_SAMPLES 4096
+
+// Number of segments of the equal-power ramp table.
+#define ENT_GLITCH_RAMP_TABLE_SIZE 1024
+
+// The fade gains are read from the table in chunks of this size.
+#define ENT_GLITCH_FADE_CHUNK 64
+
+enum ent_glitch_ramp_table_state {
+        ENT_GLITCH_RAMP_TABLE_NONE     = 0,
+        ENT_GLITCH_RAMP_TABLE_BUILDING = 1,
+        ENT_GLITCH_RAMP_TABLE_READY    = 2
+};
+
+/**
+ * The equal-power fade in sin(t * pi / 2) over t in [0, 1], built once
+ * and shared read-only by all instances. The table has an extra point
+ * at the end for the interpolation.
+ */
+static float ent_glitch_ramp_table[ENT_GLITCH_RAMP_TABLE_SIZE + 1];
+static atomic_int ent_glitch_ramp_table_state = ENT_GLITCH_RAMP_TABLE_NONE;
 
 struct ent_glitch {
         // Parameters
@@ -39,64 +65,145 @@ struct ent_glitch {
         int repeats;
         float dry;
         float wet;
+        float crossfade;
+        float speed;
+        enum ent_glitch_interpolation interpolation;
 
         int sample_rate;
         int glitch_length_samples;
         int jump_min_samples;
         int jump_max_samples;
-        float *buffer[2];
-        size_t buffer_size;
-        size_t write_pos;
         int glitch_pos;
         int glitch_count;
+        // The position in the current repeat.
         int glitch_play_pos;
         struct qx_randomizer prob_randomizer;
         struct qx_randomizer randomizer;
+        struct qx_random_buffer prob_values;
         int crossfade_len;
+        // The table segments per sample of the fades.
+        float crossfade_step;
 };
 
-struct ent_glitch* ent_glitch_create(int sample_rate)
+static void ent_glitch_init_ramp_table(void)
 {
-        struct ent_glitch* g = calloc(1, sizeof(struct ent_glitch));
-        if (!g)
-                return NULL;
+        int state = ENT_GLITCH_RAMP_TABLE_NONE;
+        if (atomic_compare_exchange_strong(&ent_glitch_ramp_table_state,
+                                           &state,
+                                           ENT_GLITCH_RAMP_TABLE_BUILDING)) {
+                for (size_t i = 0; i <= ENT_GLITCH_RAMP_TABLE_SIZE; i++) {
+                        float t = (float)i / ENT_GLITCH_RAMP_TABLE_SIZE;
+                        ent_glitch_ramp_table[i] = sinf(0.5f * (float)M_PI * t);
+                }
+                atomic_store_explicit(&ent_glitch_ramp_table_state,
+                                      ENT_GLITCH_RAMP_TABLE_READY,
+                                      memory_order_release);
+                return;
+        }
+
+        // Wait if another instance is building the table.
+        while (atomic_load_explicit(&ent_glitch_ramp_table_state, memory_order_acquire)
+               != ENT_GLITCH_RAMP_TABLE_READY)
+                ;
+}
+
+/**
+ * Reads n gains of the ramp from the table position pos [0, table size],
+ * moving by step per sample. The positions past the last segment
+ * interpolate to the end of the table.
+ */
+static void ent_glitch_ramp_read(float *gain, float pos, float step, size_t n)
+{
+        for (size_t i = 0; i < n; i++) {
+                float p = pos + (float)i * step;
+                int index = QX_MIN((int)p, ENT_GLITCH_RAMP_TABLE_SIZE - 1);
+                float frac = p - (float)index;
+                gain[i] = ent_glitch_ramp_table[index]
+                        + frac * (ent_glitch_ramp_table[index + 1] - ent_glitch_ramp_table[index]);
+        }
+}
+
+/**
+ * Converts the fade to samples. The fades are read from the shared
+ * table while the repeats play, nothing is rebuilt by the setters.
+ */
+static void ent_glitch_update_crossfade(struct ent_glitch *g)
+{
+        int len = (int)(g->crossfade * g->sample_rate / 1000.0f);
+        len = QX_MIN(len, g->glitch_length_samples / 2);
+        len = QX_CLAMP(len, 1, ENT_GLITCH_MAX_CROSSFADE_SAMPLES);
+        g->crossfade_len = len;
+        g->crossfade_step = (float)ENT_GLITCH_RAMP_TABLE_SIZE / (float)len;
+}
+
+size_t ent_glitch_size(void)
+{
+        return sizeof(struct ent_glitch);
+}
+
+struct ent_glitch* ent_glitch_init(void *mem, int sample_rate)
+{
+        struct ent_glitch* g = mem;
+        memset(g, 0, sizeof(struct ent_glitch));
+        ent_glitch_init_ramp_table();
 
         g->sample_rate = sample_rate;
         g->enabled = false;
         g->probability = ENT_GLITCH_DEFAULT_PROB;
+        g->min_jump = ENT_GLITCH_DEFAULT_MIN_JUMP;
+        g->max_jump = ENT_GLITCH_DEFAULT_MAX_JUMP;
+        g->length = ENT_GLITCH_DEFAULT_LENGH;
         g->jump_min_samples = sample_rate * ENT_GLITCH_DEFAULT_MIN_JUMP / 1000;
         g->jump_max_samples = sample_rate * ENT_GLITCH_DEFAULT_MAX_JUMP / 1000;
         g->glitch_length_samples = sample_rate *  (ENT_GLITCH_DEFAULT_LENGH / 1000.0f);
         g->repeats = ENT_GLITCH_DEFAULT_REPEATS;
         g->dry = ENT_GLITCH_DEFAULT_DRY;
         g->dry = ENT_GLITCH_DEFAULT_WET;
-
-        g->buffer_size = sample_rate * (ENT_GLITCH_MAX_MAX_JUMP + ENT_GLITCH_MAX_LENGH)
-                                     * ENT_GLITCH_MAX_REPEATS / 1000.0f;
-        g->buffer[0] = calloc(g->buffer_size, sizeof(float));
-        g->buffer[1] = calloc(g->buffer_size, sizeof(float));
-        g->write_pos = 0;
         g->glitch_pos = -1;
         g->glitch_count = 0;
         g->glitch_play_pos = 0;
-        g->crossfade_len = 128;
+        g->crossfade = ENT_GLITCH_DEFAULT_CROSSFADE;
+        ent_glitch_update_crossfade(g);
+        g->speed = ENT_GLITCH_DEFAULT_SPEED;
+        g->interpolation = ENT_GLITCH_DEFAULT_INTERP;
 
         qx_randomizer_init(&g->prob_randomizer, 0.0f, 1.0f, 1.0f / 65536.0f);
         qx_randomizer_init(&g->randomizer, 0.0f, 1.0f, 1.0f / 65536.0f);
+        qx_random_buffer_init(&g->prob_values);
 
         return g;
 }
 
+struct ent_glitch* ent_glitch_create(int sample_rate)
+{
+        struct ent_glitch* g = malloc(sizeof(struct ent_glitch));
+        if (!g)
+                return NULL;
+
+        return ent_glitch_init(g, sample_rate);
+}
+
 void ent_glitch_free(struct ent_glitch **g)
 {
         if (g && *g) {
-                free((*g)->buffer[0]);
-                free((*g)->buffer[1]);
                 free(*g);
                 *g = NULL;
         }
 }
 
+void ent_glitch_set_sample_rate(struct ent_glitch *g, int sample_rate)
+{
+        g->sample_rate = sample_rate;
+        ent_glitch_set_jump_min(g, g->min_jump);
+        ent_glitch_set_jump_max(g, g->max_jump);
+        ent_glitch_set_length(g, g->length);
+
+        // The history positions are not valid at the new rate.
+        g->glitch_pos = -1;
+        g->glitch_count = 0;
+        g->glitch_play_pos = 0;
+}
+
 enum ent_error ent_glitch_enable(struct ent_glitch *g, bool b)
 {
         g->enabled = b;
@@ -155,6 +262,7 @@ enum ent_error ent_glitch_set_length(struct ent_glitch *g, float length_ms)
                                    ENT_GLITCH_MIN_LENGH,
                                    ENT_GLITCH_MAX_LENGH);
         g->glitch_length_samples = (int)(g->length * g->sample_rate / 1000.0f);
+        ent_glitch_update_crossfade(g);
         return ENT_OK;
 }
 
@@ -202,82 +310,251 @@ float ent_glitch_get_wet(const struct ent_glitch *g)
         return g->wet;
 }
 
+enum ent_error ent_glitch_set_crossfade(struct ent_glitch *g, float crossfade_ms)
+{
+        g->crossfade = qx_clamp_float(crossfade_ms,
+                                      ENT_GLITCH_MIN_CROSSFADE,
+                                      ENT_GLITCH_MAX_CROSSFADE);
+        ent_glitch_update_crossfade(g);
+        return ENT_OK;
+}
+
+float ent_glitch_get_crossfade(const struct ent_glitch *g)
+{
+        return g->crossfade;
+}
+
+enum ent_error ent_glitch_set_speed(struct ent_glitch *g, float speed)
+{
+        g->speed = qx_clamp_float(speed,
+                                  ENT_GLITCH_MIN_SPEED,
+                                  ENT_GLITCH_MAX_SPEED);
+        return ENT_OK;
+}
+
+float ent_glitch_get_speed(const struct ent_glitch *g)
+{
+        return g->speed;
+}
+
+enum ent_error ent_glitch_set_interpolation(struct ent_glitch *g,
+                                            enum ent_glitch_interpolation interp)
+{
+        if (interp < 0 || interp >= ENT_GLITCH_INTERP_NUM_TYPES)
+                interp = ENT_GLITCH_DEFAULT_INTERP;
+
+        g->interpolation = interp;
+        return ENT_OK;
+}
+
+enum ent_glitch_interpolation ent_glitch_get_interpolation(const struct ent_glitch *g)
+{
+        return g->interpolation;
+}
+
+static ENT_ALWAYS_INLINE void
+ent_glitch_mix(float *out,
+               const float *in,
+               const float *src,
+               const float *gain,
+               float dry,
+               float wet,
+               size_t n)
+{
+        if (gain == NULL) {
+                for (size_t i = 0; i < n; i++)
+                        out[i] += dry * in[i] + wet * src[i];
+        } else {
+                for (size_t i = 0; i < n; i++)
+                        out[i] += dry * in[i] + wet * (src[i] * gain[i]);
+        }
+}
+
+static void ent_glitch_mix_dry(float *out, const float *in, float dry, size_t n)
+{
+        for (size_t i = 0; i < n; i++)
+                out[i] += dry * in[i];
+}
+
+/**
+ * Returns the ring position of the first sample of a pitched repeat,
+ * moved forward by the ring size to stay positive. The reverse reads
+ * backwards from the jump point and the faster speeds start earlier,
+ * so the repeat doesn't read past the input written so far.
+ */
+static double ent_glitch_read_start(const struct ent_history *history,
+                                    int g_pos,
+                                    float speed,
+                                    int g_len)
+{
+        double start = (double)g_pos + (double)(history->mask + 1);
+        if (speed < 0.0f)
+                return start - 2.0;
+        if (speed > 1.0f)
+                start -= (double)(speed - 1.0f) * g_len;
+        return start;
+}
+
+/**
+ * Mixes n samples of a pitched repeat read from the history at the
+ * ring position pos.
+ */
+static void ent_glitch_mix_pitched(const struct ent_glitch *g,
+                                   const struct ent_history *history,
+                                   double pos,
+                                   const float *gain,
+                                   const float *in_l,
+                                   const float *in_r,
+                                   float *out_l,
+                                   float *out_r,
+                                   size_t n)
+{
+        float src_l[QX_RING_READ_CHUNK];
+        float src_r[QX_RING_READ_CHUNK];
+        const double speed = g->speed;
+
+        for (size_t i = 0; i < n; i += QX_RING_READ_CHUNK) {
+                size_t m = QX_MIN(n - i, (size_t)QX_RING_READ_CHUNK);
+                double p = pos + (double)i * speed;
+                if (g->interpolation == ENT_GLITCH_INTERP_HERMITE) {
+                        qx_ring_read_hermite(history->buffer[0], history->mask, p, speed, src_l, m);
+                        qx_ring_read_hermite(history->buffer[1], history->mask, p, speed, src_r, m);
+                } else {
+                        qx_ring_read_linear(history->buffer[0], history->mask, p, speed, src_l, m);
+                        qx_ring_read_linear(history->buffer[1], history->mask, p, speed, src_r, m);
+                }
+
+                const float *span_gain = gain ? gain + i : NULL;
+                ent_glitch_mix(out_l + i, in_l + i, src_l, span_gain, g->dry, g->wet, m);
+                ent_glitch_mix(out_r + i, in_r + i, src_r, span_gain, g->dry, g->wet, m);
+        }
+}
+
 void ent_glitch_process(struct ent_glitch *g,
-                          float **in,
-                          float **out,
-                          size_t size)
+                        const struct ent_history *history,
+                        float **in,
+                        float **out,
+                        size_t size)
 {
-        size_t write_pos   = g->write_pos;
+        const float dry = g->dry;
+        float *in_l  = in[0];
+        float *in_r  = in[1];
+        float *out_l = out[0];
+        float *out_r = out[1];
+
+        if (history == NULL) {
+                ent_glitch_mix_dry(out_l, in_l, dry, size);
+                ent_glitch_mix_dry(out_r, in_r, dry, size);
+                return;
+        }
+
+        // The position of the first sample of the block in the history.
+        const size_t mask = history->mask;
+        const size_t block_pos = (history->write_pos - size) & mask;
+
         int g_pos          = g->glitch_pos;
         int g_count        = g->glitch_count;
         int play_pos       = g->glitch_play_pos;
         struct qx_randomizer *prob_randomizer = &g->prob_randomizer;
+        struct qx_random_buffer *prob_values = &g->prob_values;
         struct qx_randomizer *randomizer = &g->randomizer;
 
-        const size_t buf_size = g->buffer_size;
         const int g_len       = g->glitch_length_samples;
         const float prob      = g->probability;
         const int j_min       = g->jump_min_samples;
         const int j_range     = fabsf(g->jump_max_samples - j_min);
         const int repeats     = g->repeats;
-        const float dry       = g->dry;
         const float wet       = g->wet;
+        const float speed     = g->speed;
 
-        const int crossfade_len = g->crossfade_len;
-        const float k = 1.0f / (float)crossfade_len;
-        const float a = k * (float)g_len;
-
-        float *buf_l = g->buffer[0];
-        float *buf_r = g->buffer[1];
-        float *in_l  = in[0];
-        float *in_r  = in[1];
-        float *out_l = out[0];
-        float *out_r = out[1];
-
-        for (size_t i = 0; i < size; i++) {
-                float s_l = in_l[i];
-                float s_r = in_r[i];
+        // The repeat is split into the fade in [0, fade_in_end), the
+        // unity gain part and the fade out [fade_out_start, g_len).
+        // The fade is at most half of the length.
+        const int fade_in_end = g->crossfade_len;
+        const int fade_out_start = g_len - g->crossfade_len;
+        const float fade_step = g->crossfade_step;
+        float fade[ENT_GLITCH_FADE_CHUNK];
 
-                buf_l[write_pos] = s_l;
-                buf_r[write_pos] = s_r;
+        const float *buf_l = history->buffer[0];
+        const float *buf_r = history->buffer[1];
 
-                float gs_l = 0;
-                float gs_r = 0;
+        // The length may have changed while a repeat was playing.
+        if (play_pos >= g_len)
+                play_pos = 0;
 
+        size_t i = 0;
+        while (i < size) {
                 if (g_count > 0 && g_pos >= 0) {
-                        float crossfade_gain = 1.0f;
-                        size_t play_offset = play_pos % g_len;
-                        size_t pb_idx = (g_pos + play_offset) % buf_size;
-
-                        if (play_offset < crossfade_len) {
-                                // Fade in
-                                crossfade_gain = k * (float)play_offset;
-                        } else if (play_offset >= g_len - crossfade_len) {
-                                // Fade out
-                                crossfade_gain = -k * (float)play_offset + a;
+                        // Render a span that doesn't cross the end of the
+                        // repeat, the end of the ring or a crossfade edge.
+                        const float *gain = NULL;
+                        int span_end;
+                        if (play_pos < fade_in_end) {
+                                gain = fade;
+                                span_end = fade_in_end;
+                        } else if (play_pos < fade_out_start) {
+                                span_end = fade_out_start;
+                        } else {
+                                gain = fade;
+                                span_end = g_len;
                         }
 
-                        gs_l = buf_l[pb_idx] * crossfade_gain;
-                        gs_r = buf_r[pb_idx] * crossfade_gain;
-
-                        play_pos++;
-                        g_count--;
-                } else if (qx_randomizer_get_float(prob_randomizer) < prob) {
-                        float jump_prob = qx_randomizer_get_float(randomizer);
-                        int jump = j_min + (int)(jump_prob * j_range);
+                        size_t n = QX_MIN(size - i, (size_t)(span_end - play_pos));
+                        n = QX_MIN(n, (size_t)g_count);
+                        if (gain != NULL) {
+                                // The fade out reads the table backwards from its end.
+                                n = QX_MIN(n, (size_t)ENT_GLITCH_FADE_CHUNK);
+                                if (play_pos < fade_in_end)
+                                        ent_glitch_ramp_read(fade, (float)play_pos * fade_step,
+                                                             fade_step, n);
+                                else
+                                        ent_glitch_ramp_read(fade, (float)(g_len - play_pos) * fade_step,
+                                                             -fade_step, n);
+                        }
 
-                        g_pos = (write_pos + buf_size - (jump % buf_size)) % buf_size;
-                        g_count = g_len * repeats;
-                        play_pos = 0;
-                }
+                        if (speed == 1.0f) {
+                                size_t pb_idx = ((size_t)g_pos + play_pos) & mask;
+                                n = QX_MIN(n, mask + 1 - pb_idx);
+                                ent_glitch_mix(out_l + i, in_l + i, buf_l + pb_idx, gain, dry, wet, n);
+                                ent_glitch_mix(out_r + i, in_r + i, buf_r + pb_idx, gain, dry, wet, n);
+                        } else {
+                                double pos = ent_glitch_read_start(history, g_pos, speed, g_len)
+                                        + (double)play_pos * speed;
+                                ent_glitch_mix_pitched(g, history, pos, gain,
+                                                       in_l + i, in_r + i,
+                                                       out_l + i, out_r + i,
+                                                       n);
+                        }
 
-                out_l[i] += dry * s_l + wet * gs_l;
-                out_r[i] += dry * s_r + wet * gs_r;
+                        play_pos += n;
+                        if (play_pos == g_len)
+                                play_pos = 0;
+                        g_count -= n;
+                        i += n;
+                } else {
+                        // Only the input passes until the next glitch starts.
+                        size_t start = i;
+                        while (i < size
+                               && qx_random_buffer_next(prob_values, prob_randomizer) >= prob)
+                                i++;
+
+                        if (i < size) {
+                                float jump_prob = qx_randomizer_get_float(randomizer);
+                                int jump = j_min + (int)(jump_prob * j_range);
+
+                                g_pos = (block_pos + i - (size_t)jump) & mask;
+                                g_count = g_len * repeats;
+                                play_pos = 0;
+
+                                // The glitch plays from the next sample.
+                                i++;
+                        }
 
-                write_pos = (write_pos + 1) % buf_size;
+                        ent_glitch_mix_dry(out_l + start, in_l + start, dry, i - start);
+                        ent_glitch_mix_dry(out_r + start, in_r + start, dry, i - start);
+                }
         }
 
-        g->write_pos       = write_pos;
         g->glitch_pos      = g_pos;
         g->glitch_count    = g_count;
         g->glitch_play_pos = play_pos;
@@ -293,6 +570,9 @@ void ent_glitch_set_state(struct ent_glitch *g, const struct ent_state_glitch *s
         ENT_SET_STATE(g, state, repeats,     ent_glitch_set_repeat_count);
         ENT_SET_STATE(g, state, dry,         ent_glitch_set_dry);
         ENT_SET_STATE(g, state, wet,         ent_glitch_set_wet);
+        ENT_SET_STATE(g, state, crossfade,   ent_glitch_set_crossfade);
+        ENT_SET_STATE(g, state, speed,       ent_glitch_set_speed);
+        ENT_SET_STATE(g, state, interpolation, ent_glitch_set_interpolation);
 }
 
 void ent_glitch_get_state(const struct ent_glitch *g, struct ent_state_glitch *state)
@@ -305,4 +585,7 @@ void ent_glitch_get_state(const struct ent_glitch *g, struct ent_state_glitch *s
         ENT_GET_STATE(g, state, repeats,     ent_glitch_get_repeat_count);
         ENT_GET_STATE(g, state, dry,         ent_glitch_get_dry);
         ENT_GET_STATE(g, state, wet,         ent_glitch_get_wet);
+        ENT_GET_STATE(g, state, crossfade,   ent_glitch_get_crossfade);
+        ENT_GET_STATE(g, state, speed,       ent_glitch_get_speed);
+        ENT_GET_STATE(g, state, interpolation, ent_glitch_get_interpolation);
 }
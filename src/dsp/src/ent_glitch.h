@@ -53,6 +53,18 @@ extern "C" {
 #define ENT_GLITCH_DEFAULT_MIN_JUMP 0.0f   // ms
 #define ENT_GLITCH_DEFAULT_MAX_JUMP 50.0f  // ms
 
+// The input history must hold the longest jump plus all the repeats
+// read at the highest speed, forwards or backwards. A reverse repeat
+// reads back |speed| times its length from the jump position.
+#define ENT_GLITCH_HISTORY_LENGTH (ENT_GLITCH_MAX_MAX_JUMP \
+                                   + ENT_GLITCH_MAX_ABS_SPEED   \
+                                   * ENT_GLITCH_MAX_LENGH       \
+                                   * ENT_GLITCH_MAX_REPEATS) // ms
+
+// Samples around the read position used by the Hermite interpolation
+// and the offset of the reverse read start.
+#define ENT_GLITCH_HISTORY_TAPS 4
+
 #define ENT_GLITCH_MIN_DRY 0.0f
 #define ENT_GLITCH_MAX_DRY 1.0f
 #define ENT_GLITCH_DEFAULT_DRY 0.0f
@@ -61,13 +73,48 @@ extern "C" {
 #define ENT_GLITCH_MAX_WET 1.0f
 #define ENT_GLITCH_DEFAULT_WET 1.0f
 
+// The fade at the start and the end of each repeat.
+#define ENT_GLITCH_MIN_CROSSFADE     0.5f  // ms
+#define ENT_GLITCH_MAX_CROSSFADE     20.0f // ms
+#define ENT_GLITCH_DEFAULT_CROSSFADE 2.5f  // ms
+
+// Playback speed of the repeats, negative plays in reverse.
+#define ENT_GLITCH_MIN_SPEED     -2.0f
+#define ENT_GLITCH_MAX_SPEED     2.0f
+#define ENT_GLITCH_MAX_ABS_SPEED (-ENT_GLITCH_MIN_SPEED > ENT_GLITCH_MAX_SPEED \
+                                  ? -ENT_GLITCH_MIN_SPEED : ENT_GLITCH_MAX_SPEED)
+#define ENT_GLITCH_DEFAULT_SPEED 1.0f
+
+enum ent_glitch_interpolation {
+        ENT_GLITCH_INTERP_LINEAR  = 0,
+        ENT_GLITCH_INTERP_HERMITE = 1,
+        ENT_GLITCH_INTERP_NUM_TYPES
+};
+
+#define ENT_GLITCH_DEFAULT_INTERP ENT_GLITCH_INTERP_LINEAR
+
 struct ent_glitch;
+struct ent_history;
 struct ent_state_glitch;
 
 struct ent_glitch* ent_glitch_create(int sample_rate);
 
+/**
+ * Returns the size of the module, used to place it in memory
+ * provided by the caller with ent_glitch_init().
+ */
+size_t ent_glitch_size(void);
+
+struct ent_glitch* ent_glitch_init(void *mem, int sample_rate);
+
 void ent_glitch_free(struct ent_glitch **g);
 
+/**
+ * Updates the sample rate dependent state and stops the current
+ * glitch. Doesn't allocate, can be called from the audio thread.
+ */
+void ent_glitch_set_sample_rate(struct ent_glitch *g, int sample_rate);
+
 enum ent_error ent_glitch_enable(struct ent_glitch *g, bool b);
 
 bool ent_glitch_is_enabled(const struct ent_glitch *g);
@@ -100,7 +147,36 @@ enum ent_error ent_glitch_set_wet(struct ent_glitch *g, float wet);
 
 float ent_glitch_get_wet(const struct ent_glitch *g);
 
+/**
+ * Sets the equal-power fade in ms applied at the start and the end of
+ * each repeat. The fade is limited to half of the glitch length.
+ */
+enum ent_error ent_glitch_set_crossfade(struct ent_glitch *g, float crossfade_ms);
+
+float ent_glitch_get_crossfade(const struct ent_glitch *g);
+
+/**
+ * Sets the playback speed of the repeats, it changes the pitch too.
+ * A negative speed plays the repeats in reverse from the jump point.
+ */
+enum ent_error ent_glitch_set_speed(struct ent_glitch *g, float speed);
+
+float ent_glitch_get_speed(const struct ent_glitch *g);
+
+/**
+ * Sets the interpolation used when the speed is other than 1.
+ */
+enum ent_error ent_glitch_set_interpolation(struct ent_glitch *g,
+                                            enum ent_glitch_interpolation interp);
+
+enum ent_glitch_interpolation ent_glitch_get_interpolation(const struct ent_glitch *g);
+
+/**
+ * Processes the input block that was just written to the history.
+ * Without history (NULL) only the dry signal is output.
+ */
 void ent_glitch_process(struct ent_glitch *g,
+                        const struct ent_history *history,
                         float **in,
                         float **out,
                         size_t size);
@@ -0,0 +1,91 @@
+/**
+ * File name: ent_history.c
+ * Project: Entropictron (A texture synthesizer)
+ *
+ * Copyright (C) 2025 Iurie Nistor
+ *
+ * This file is part of Entropictron.
+ *
+ * Entropictron is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "ent_history.h"
+#include "ent_memory.h"
+
+#include <string.h>
+
+static size_t ent_history_round_size(size_t size)
+{
+        size_t n = 1;
+        while (n < size)
+                n <<= 1;
+        return n;
+}
+
+struct ent_history* ent_history_create(int sample_rate,
+                                       float length_ms,
+                                       size_t max_block)
+{
+        struct ent_history *history = ent_aligned_alloc(sizeof(struct ent_history));
+        if (!history)
+                return NULL;
+
+        history->sample_rate = sample_rate;
+        history->size = ent_history_round_size((size_t)(sample_rate * length_ms / 1000.0f)
+                                               + max_block);
+        history->mask = history->size - 1;
+        history->buffer[0] = ent_aligned_alloc(history->size * sizeof(float));
+        history->buffer[1] = ent_aligned_alloc(history->size * sizeof(float));
+        if (!history->buffer[0] || !history->buffer[1]) {
+                ent_history_free(&history);
+                return NULL;
+        }
+
+        history->memory[0].ptr = history;
+        history->memory[0].size = sizeof(struct ent_history);
+        for (size_t ch = 0; ch < 2; ch++) {
+                history->memory[ch + 1].ptr = history->buffer[ch];
+                history->memory[ch + 1].size = history->size * sizeof(float);
+        }
+
+        return history;
+}
+
+void ent_history_free(struct ent_history **history)
+{
+        if (history && *history) {
+                ent_aligned_free((*history)->buffer[0]);
+                ent_aligned_free((*history)->buffer[1]);
+                ent_aligned_free(*history);
+                *history = NULL;
+        }
+}
+
+void ent_history_write(struct ent_history *history,
+                       float **data,
+                       size_t size)
+{
+        size_t pos = history->write_pos;
+        size_t n = history->size - pos;
+        if (n > size)
+                n = size;
+
+        for (size_t ch = 0; ch < 2; ch++) {
+                memcpy(history->buffer[ch] + pos, data[ch], n * sizeof(float));
+                memcpy(history->buffer[ch], data[ch] + n, (size - n) * sizeof(float));
+        }
+
+        history->write_pos = (pos + size) & history->mask;
+}
@@ -0,0 +1,71 @@
+/**
+ * File name: ent_history.h
+ * Project: Entropictron (A texture synthesizer)
+ *
+ * Copyright (C) 2025 Iurie Nistor
+ *
+ * This file is part of Entropictron.
+ *
+ * Entropictron is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef ENT_HISTORY_H
+#define ENT_HISTORY_H
+
+#include "ent_defs.h"
+#include "ent_memory.h"
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Stereo input history ring buffer.
+ *
+ * The history is written once per block and can be read
+ * by many modules (e.g. the glitch modules). The size is a power
+ * of two, so positions wrap with the mask instead of a modulo.
+ */
+struct ent_history {
+        float *buffer[2];
+        int sample_rate;
+        size_t size;
+        size_t mask;
+        size_t write_pos;
+        // The blocks of the history: the history and the buffers.
+        struct ent_memory_region memory[3];
+};
+
+/**
+ * Creates a history of length_ms at the given sample rate. Writes of
+ * up to max_block frames keep the last length_ms of input readable.
+ * The size is rounded up to the next power of two.
+ */
+struct ent_history* ent_history_create(int sample_rate,
+                                       float length_ms,
+                                       size_t max_block);
+
+void ent_history_free(struct ent_history **history);
+
+void ent_history_write(struct ent_history *history,
+                       float **data,
+                       size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+#endif // ENT_HISTORY_H
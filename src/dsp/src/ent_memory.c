@@ -0,0 +1,120 @@
+/**
+ * File name: ent_memory.c
+ * Project: Entropictron (A texture synthesizer)
+ *
+ * Copyright (C) 2025 Iurie Nistor
+ *
+ * This file is part of Entropictron.
+ *
+ * Entropictron is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef ENTROPICTRON_OS_WINDOWS
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "ent_memory.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef ENTROPICTRON_OS_WINDOWS
+#include <malloc.h>
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+// The smallest page size of the supported platforms.
+#define ENT_MEMORY_PAGE_SIZE 4096
+
+void* ent_aligned_alloc(size_t size)
+{
+        // aligned_alloc() requires the size to be a multiple of the alignment.
+        size = (size + ENT_CACHE_LINE_SIZE - 1) & ~((size_t)ENT_CACHE_LINE_SIZE - 1);
+        if (size == 0)
+                size = ENT_CACHE_LINE_SIZE;
+
+#ifdef ENTROPICTRON_OS_WINDOWS
+        void *ptr = _aligned_malloc(size, ENT_CACHE_LINE_SIZE);
+#else
+        void *ptr = aligned_alloc(ENT_CACHE_LINE_SIZE, size);
+#endif
+        if (ptr != NULL)
+                memset(ptr, 0, size);
+        return ptr;
+}
+
+void ent_aligned_free(void *ptr)
+{
+#ifdef ENTROPICTRON_OS_WINDOWS
+        _aligned_free(ptr);
+#else
+        free(ptr);
+#endif
+}
+
+void ent_memory_prefault(void *ptr, size_t size)
+{
+        if (ptr == NULL || size == 0)
+                return;
+
+        volatile char *mem = ptr;
+        for (size_t i = 0; i < size; i += ENT_MEMORY_PAGE_SIZE)
+                mem[i] = mem[i];
+        mem[size - 1] = mem[size - 1];
+}
+
+bool ent_memory_lock(void *ptr, size_t size)
+{
+        if (ptr == NULL || size == 0)
+                return true;
+
+#ifdef ENTROPICTRON_OS_WINDOWS
+        return VirtualLock(ptr, size) != 0;
+#else
+        return mlock(ptr, size) == 0;
+#endif
+}
+
+void ent_memory_unlock(void *ptr, size_t size)
+{
+        if (ptr == NULL || size == 0)
+                return;
+
+#ifdef ENTROPICTRON_OS_WINDOWS
+        VirtualUnlock(ptr, size);
+#else
+        munlock(ptr, size);
+#endif
+}
+
+void ent_arena_init(struct ent_arena *arena, void *mem, size_t size)
+{
+        arena->mem = mem;
+        arena->size = size;
+        arena->used = 0;
+}
+
+void* ent_arena_alloc(struct ent_arena *arena, size_t size)
+{
+        size = ENT_ARENA_SIZE(size);
+        if (arena->mem == NULL || size > arena->size - arena->used)
+                return NULL;
+
+        void *ptr = arena->mem + arena->used;
+        arena->used += size;
+        return ptr;
+}
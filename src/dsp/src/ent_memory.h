@@ -0,0 +1,97 @@
+/**
+ * File name: ent_memory.h
+ * Project: Entropictron (A texture synthesizer)
+ *
+ * Copyright (C) 2025 Iurie Nistor
+ *
+ * This file is part of Entropictron.
+ *
+ * Entropictron is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef ENT_MEMORY_H
+#define ENT_MEMORY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Cache line size used to align the DSP memory.
+#define ENT_CACHE_LINE_SIZE 64
+
+/**
+ * A block of memory used by the DSP. The regions are kept in the
+ * blocks they describe and linked in a list, so an instance can
+ * have any number of them.
+ */
+struct ent_memory_region {
+        void *ptr;
+        size_t size;
+        struct ent_memory_region *next;
+};
+
+/**
+ * Bump allocator over a block of memory. The allocations are aligned
+ * to the cache line size and are released all at once with the block.
+ */
+struct ent_arena {
+        char *mem;
+        size_t size;
+        size_t used;
+};
+
+// Size of an arena allocation, rounded up to the cache line size.
+#define ENT_ARENA_SIZE(size) \
+        (((size) + ENT_CACHE_LINE_SIZE - 1) & ~((size_t)ENT_CACHE_LINE_SIZE - 1))
+
+void ent_arena_init(struct ent_arena *arena, void *mem, size_t size);
+
+/**
+ * Returns the next size bytes of the arena, or NULL
+ * if the arena is full.
+ */
+void* ent_arena_alloc(struct ent_arena *arena, size_t size);
+
+/**
+ * Allocates zero initialized memory aligned to the cache line size.
+ * The memory is written at allocation, so it is already mapped and
+ * the first access from the audio thread doesn't page fault.
+ * The memory must be released with ent_aligned_free().
+ */
+void* ent_aligned_alloc(size_t size);
+
+void ent_aligned_free(void *ptr);
+
+/**
+ * Touches every page of the memory to map it.
+ */
+void ent_memory_prefault(void *ptr, size_t size);
+
+/**
+ * Locks the memory in RAM so it is never paged out.
+ * Returns false if the memory can't be locked
+ * (e.g. RLIMIT_MEMLOCK is too low).
+ */
+bool ent_memory_lock(void *ptr, size_t size);
+
+void ent_memory_unlock(void *ptr, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+#endif // ENT_MEMORY_H
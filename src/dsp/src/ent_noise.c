@@ -32,6 +32,39 @@
 #include "qx_fader.h"
 #include "qx_smoother.h"
 
+#include <float.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// At lower densities the white noise impulses are placed by drawing
+// the gaps between them instead of testing every sample.
+#define ENT_NOISE_SPARSE_DENSITY 0.1f
+
+// Maximum number of zero samples between the sparse impulses.
+#define ENT_NOISE_MAX_GAP ((size_t)INT32_MAX)
+
+// Level below which the filters state is flushed to zero.
+#define ENT_NOISE_SILENCE 1e-10f
+
+// Lanes of the bank, the stereo channels of the bank noises.
+#define ENT_NOISE_BANK_LANES (2 * ENT_NOISE_BANK_SIZE)
+
+// Number of samples generated into the bank lanes at once.
+#define ENT_NOISE_BANK_CHUNK 64
+
+// The brightness shelf, normalized to keep the level above the cutoff.
+static const struct ent_shelf_curve ent_noise_shelf_curve = {
+        .min_cutoff = 4000.0f,
+        .max_cutoff = 8000.0f,
+        .min_gain = 0.0f,
+        .max_gain = 6.0f,
+        .normalize = true
+};
+
 struct ent_noise {
         // Parameters
 	bool enabled;
@@ -47,8 +80,13 @@ struct ent_noise {
         struct qx_randomizer prob_randomizer;
         struct qx_randomizer randomizer;
         struct qx_randomizer stereo_randomizer;
+        struct qx_random_buffer values;
         struct qx_fader fader;
         struct qx_smoother entropy;
+        // Modulated density and gain at the end of the last block,
+        // the next block ramps from them to its own end values.
+        float density_end;
+        float gain_end;
 
         float max_gain;
         float min_gain;
@@ -65,15 +103,17 @@ struct ent_noise {
 
         // Low, band, high pass filter
         struct ent_filter filter;
-
-        float buffer[2][4096];
 };
 
-struct ent_noise* ent_noise_create(int sample_rate)
+size_t ent_noise_size(void)
 {
-        struct ent_noise* noise = calloc(1, sizeof(struct ent_noise));
-        if (!noise)
-                return NULL;
+        return sizeof(struct ent_noise);
+}
+
+struct ent_noise* ent_noise_init(void *mem, int sample_rate)
+{
+        struct ent_noise* noise = mem;
+        memset(noise, 0, sizeof(struct ent_noise));
 
         noise->sample_rate = sample_rate;
         noise->type = ENT_NOISE_TYPE_WHITE;
@@ -87,7 +127,9 @@ struct ent_noise* ent_noise_create(int sample_rate)
         noise->b1 = 0.0f;
         noise->b2 = 0.0f;
 
-        qx_smoother_init(&noise->entropy, 0.0f, 20.0f);
+        qx_smoother_init(&noise->entropy, 0.0f, 1);
+        noise->density_end = noise->density;
+        noise->gain_end = noise->gain;
 
         noise->min_gain = qx_db_to_val(ENT_NOISE_MIN_GAIN);
         noise->max_gain = qx_db_to_val(ENT_NOISE_MAX_GAIN);
@@ -101,10 +143,12 @@ struct ent_noise* ent_noise_create(int sample_rate)
         qx_randomizer_init(&noise->stereo_randomizer,
                            0.0f, 1.0f,
                            1.0f / 65536.0f);
+        qx_random_buffer_init(&noise->values);
 
         // Add a fade of 10 ms.
         qx_fader_init(&noise->fader, 10.0f, noise->sample_rate);
 
+        ent_noise_prepare(noise->sample_rate);
         ent_shelf_filter_init(&noise->sh_filter_l,
                               noise->sample_rate,
                               4000.0f,
@@ -124,6 +168,15 @@ struct ent_noise* ent_noise_create(int sample_rate)
         return noise;
 }
 
+struct ent_noise* ent_noise_create(int sample_rate)
+{
+        struct ent_noise* noise = malloc(sizeof(struct ent_noise));
+        if (!noise)
+                return NULL;
+
+        return ent_noise_init(noise, sample_rate);
+}
+
 void ent_noise_free(struct ent_noise **noise)
 {
         if (noise && *noise) {
@@ -132,6 +185,19 @@ void ent_noise_free(struct ent_noise **noise)
         }
 }
 
+void ent_noise_prepare(int sample_rate)
+{
+        ent_shelf_filter_prepare(&ent_noise_shelf_curve, sample_rate);
+}
+
+void ent_noise_set_sample_rate(struct ent_noise *noise, int sample_rate)
+{
+        noise->sample_rate = sample_rate;
+        qx_fader_set_time(&noise->fader, 10.0f, sample_rate);
+        ent_noise_set_brightness(noise, noise->brightness);
+        ent_filter_set_sample_rate(&noise->filter, sample_rate);
+}
+
 enum ent_error ent_noise_enable(struct ent_noise *noise, bool b)
 {
         noise->enabled = b;
@@ -185,27 +251,16 @@ float ent_noise_get_density(const struct ent_noise *noise)
 
 enum ent_error ent_noise_set_brightness(struct ent_noise *noise, float brightness)
 {
-    noise->brightness = qx_clamp_float(brightness, 0.01f, 1.0f);
-
-    const float min_cutoff = 4000.0f;
-    const float max_cutoff = 8000.0f;
-    const float cutoff = min_cutoff + (max_cutoff - min_cutoff) * noise->brightness;
-
-    const float min_gain = 0.0f;
-    const float max_gain = 6.0f;
-    const float gain = min_gain + (max_gain - min_gain) *  brightness;
-
-    // Update high-shelf filter for both channels
-    ent_shelf_filter_set_cutoff(&noise->sh_filter_l,
-                                noise->sample_rate,
-                                cutoff,
-                                gain);
-    ent_shelf_filter_set_cutoff(&noise->sh_filter_r,
-                                noise->sample_rate,
-                                cutoff,
-                                gain);
-
-    return ENT_OK;
+        noise->brightness = qx_clamp_float(brightness, 0.01f, 1.0f);
+        ent_shelf_filter_set_brightness(&noise->sh_filter_l,
+                                        &ent_noise_shelf_curve,
+                                        noise->sample_rate,
+                                        noise->brightness);
+        ent_shelf_filter_set_brightness(&noise->sh_filter_r,
+                                        &ent_noise_shelf_curve,
+                                        noise->sample_rate,
+                                        noise->brightness);
+        return ENT_OK;
 }
 
 float ent_noise_get_brightness(const struct ent_noise *noise)
@@ -268,8 +323,9 @@ float ent_noise_get_resonance(const struct ent_noise *noise)
         return noise->resonance;
 }
 
-void ent_noise_set_entropy(struct ent_noise *noise, float entropy)
+void ent_noise_set_entropy(struct ent_noise *noise, float entropy, size_t frames)
 {
+        qx_smoother_set_frames(&noise->entropy, frames);
         qx_smoother_set_target(&noise->entropy, entropy);
 }
 
@@ -278,30 +334,408 @@ float ent_noise_get_entropy(const struct ent_noise *noise)
         return qx_smoother_get(&noise->entropy);
 }
 
-static inline float pink_from_white(struct ent_noise *noise, float white)
+static inline float pink_from_white(float *b, float white)
 {
     // Paul Kellet 3-pole filter
-    noise->b0 = 0.99765f * noise->b0 + 0.0990460f * white;
-    noise->b1 = 0.96300f * noise->b1 + 0.2965164f * white;
-    noise->b2 = 0.57000f * noise->b2 + 1.0526913f * white;
+    b[0] = 0.99765f * b[0] + 0.0990460f * white;
+    b[1] = 0.96300f * b[1] + 0.2965164f * white;
+    b[2] = 0.57000f * b[2] + 1.0526913f * white;
 
-    const float pink = noise->b0 + noise->b1 + noise->b2 + 0.1848f * white;
+    const float pink = b[0] + b[1] + b[2] + 0.1848f * white;
 
     return pink * 0.05f;
 }
 
-static inline float brown_from_white(struct ent_noise *noise, float white)
+static inline float brown_from_white(float *brown, float white)
 {
-        noise->brown += 0.02f * white;
-        noise->brown = qx_clamp_float(noise->brown, -1.0f, 1.0f);
-        return noise->brown * 0.5f;
+        *brown += 0.02f * white;
+        *brown = qx_clamp_float(*brown, -1.0f, 1.0f);
+        return *brown * 0.5f;
 }
 
-void ent_noise_process(struct ent_noise *noise,
-                       float **data,
-                       size_t size)
+// Per block parameters of the noise kernel. The density, threshold
+// and gain are the values before the first sample, they are advanced
+// by their step before each sample.
+struct ent_noise_block {
+        float density;
+        float density_step;
+        float threshold;
+        float threshold_step;
+        bool sparse;
+        float width;
+        float gain;
+        float gain_step;
+        // The filter coefficients are interpolated over the block.
+        bool filter_ramp;
+};
+
+/**
+ * Runs a stereo sample through the brightness shelf and the filter.
+ */
+static ENT_ALWAYS_INLINE void
+ent_noise_filter_sample(struct ent_shelf_filter *sh_filter_l,
+                        struct ent_shelf_filter *sh_filter_r,
+                        struct ent_filter *filter,
+                        enum ent_filter_type filter_type,
+                        bool filter_ramp,
+                        bool shelf,
+                        float *l,
+                        float *r)
 {
-        float entropy = qx_smoother_next(&noise->entropy);
+        if (shelf) {
+                *l = ent_shelf_filter_process_sample(sh_filter_l, *l);
+                *r = ent_shelf_filter_process_sample(sh_filter_r, *r);
+        }
+
+        if (filter_type != ENT_FILTER_TYPE_ALLPASS) {
+                if (filter_ramp)
+                        ent_filter_next_coeffs(filter);
+                *l = ent_filter_process_sample(filter, filter_type, 0, *l);
+                *r = ent_filter_process_sample(filter, filter_type, 1, *r);
+                *l = qx_clamp_float(*l, -1.0f, 1.0f);
+                *r = qx_clamp_float(*r, -1.0f, 1.0f);
+        }
+}
+
+static inline bool ent_noise_flush(float *state)
+{
+        if (fabsf(*state) < ENT_NOISE_SILENCE) {
+                *state = 0.0f;
+                return true;
+        }
+        return false;
+}
+
+/**
+ * Flushes to zero the filters state that has decayed, the shelf
+ * can decay to denormals while the filter is still ringing. Returns
+ * true if all the state has decayed.
+ */
+static bool ent_noise_flush_filters(struct ent_shelf_filter *sh_filter_l,
+                                    struct ent_shelf_filter *sh_filter_r,
+                                    struct ent_filter *filter)
+{
+        bool silent = ent_noise_flush(&sh_filter_l->z1);
+        silent = ent_noise_flush(&sh_filter_l->z2) && silent;
+        silent = ent_noise_flush(&sh_filter_r->z1) && silent;
+        silent = ent_noise_flush(&sh_filter_r->z2) && silent;
+        for (size_t ch = 0; ch < 2; ch++) {
+                silent = ent_noise_flush(&filter->ic1eq[ch]) && silent;
+                silent = ent_noise_flush(&filter->ic2eq[ch]) && silent;
+        }
+        return silent;
+}
+
+/**
+ * Draws the number of zero samples before the next impulse, an
+ * impulse occurs at each sample with the probability density.
+ */
+static size_t ent_noise_draw_gap(struct ent_noise *noise, float density)
+{
+        if (density <= 0.0f)
+                return ENT_NOISE_MAX_GAP;
+
+        // Uniform value in [0, 1].
+        const float u = 0.5f * (qx_randomizer_get_float(&noise->prob_randomizer) + 1.0f);
+        if (u <= 0.0f)
+                return ENT_NOISE_MAX_GAP;
+
+        const float gap = logf(u) / log1pf(-density);
+        if (gap < (float)ENT_NOISE_MAX_GAP)
+                return (size_t)gap;
+        return ENT_NOISE_MAX_GAP;
+}
+
+/**
+ * Generates the next sample of the noise, faded and spread to the
+ * stereo channels, before the filters. The prob and stereo values are
+ * the random values drawn for the sample.
+ */
+static ENT_ALWAYS_INLINE void
+ent_noise_source_sample(struct ent_noise *noise,
+                        struct qx_fader *fader,
+                        float *pink,
+                        float *brown,
+                        float threshold,
+                        float width,
+                        float prob_value,
+                        float stereo_value,
+                        enum ent_noise_type type,
+                        bool stereo,
+                        float *l,
+                        float *r)
+{
+        float val = qx_random_buffer_next_if(&noise->values,
+                                             &noise->randomizer,
+                                             prob_value <= threshold);
+
+        if (type == ENT_NOISE_TYPE_PINK)
+                val = pink_from_white(pink, val);
+        else if (type == ENT_NOISE_TYPE_BROWN)
+                val = brown_from_white(brown, val);
+
+        val = qx_fader_fade(fader, val);
+
+        // Calculate random stereo channel, the width is at most 0.5 so
+        // at most one channel is muted.
+        *l = val;
+        *r = val;
+        if (stereo) {
+                *r = stereo_value < width ? 0.0f : val;
+                *l = stereo_value > 1.0f - width ? 0.0f : val;
+        }
+}
+
+/**
+ * Generates the noise and runs it through the fader, stereo spread,
+ * brightness shelf, filter and gain in a single pass, adding it to data.
+ * The type, filter type, shelf and stereo arguments are constants at each
+ * call site, so each combination is compiled to a loop without branches
+ * on them.
+ */
+static ENT_ALWAYS_INLINE void
+ent_noise_render(struct ent_noise *noise,
+                 const struct ent_noise_block *block,
+                 float **data,
+                 size_t size,
+                 enum ent_noise_type type,
+                 enum ent_filter_type filter_type,
+                 bool shelf,
+                 bool stereo)
+{
+        // Local copies of the state, kept in registers by the loop.
+        struct qx_fader fader = noise->fader;
+        struct ent_shelf_filter sh_filter_l = noise->sh_filter_l;
+        struct ent_shelf_filter sh_filter_r = noise->sh_filter_r;
+        struct ent_filter filter = noise->filter;
+        float pink[3] = {noise->b0, noise->b1, noise->b2};
+        float brown = noise->brown;
+
+        float threshold = block->threshold;
+        const float threshold_step = block->threshold_step;
+        const float width = block->width;
+        float gain = block->gain;
+        const float gain_step = block->gain_step;
+        const bool filter_ramp = block->filter_ramp;
+        float *out_l = data[0];
+        float *out_r = data[1];
+
+        float prob_values[QX_RANDOM_BUFFER_SIZE];
+        float stereo_values[QX_RANDOM_BUFFER_SIZE];
+        for (size_t i = 0; i < size; i++) {
+                threshold += threshold_step;
+                gain += gain_step;
+
+                // Generate the random values consumed per sample in blocks.
+                const size_t tile_pos = i % QX_RANDOM_BUFFER_SIZE;
+                if (tile_pos == 0) {
+                        size_t n = size - i;
+                        if (n > QX_RANDOM_BUFFER_SIZE)
+                                n = QX_RANDOM_BUFFER_SIZE;
+                        qx_randomizer_fill(&noise->prob_randomizer, prob_values, n);
+                        if (stereo)
+                                qx_randomizer_fill(&noise->stereo_randomizer, stereo_values, n);
+                }
+
+                float l;
+                float r;
+                ent_noise_source_sample(noise, &fader, pink, &brown, threshold, width,
+                                        prob_values[tile_pos],
+                                        stereo ? stereo_values[tile_pos] : 0.0f,
+                                        type, stereo, &l, &r);
+
+                ent_noise_filter_sample(&sh_filter_l, &sh_filter_r, &filter,
+                                        filter_type, filter_ramp, shelf, &l, &r);
+
+                out_l[i] += l * gain;
+                out_r[i] += r * gain;
+        }
+
+        noise->fader = fader;
+        noise->sh_filter_l = sh_filter_l;
+        noise->sh_filter_r = sh_filter_r;
+        noise->filter = filter;
+        noise->b0 = pink[0];
+        noise->b1 = pink[1];
+        noise->b2 = pink[2];
+        noise->brown = brown;
+}
+
+/**
+ * Renders sparse white noise. Only the impulses are generated, between
+ * them the filters run with zero input until their state decays, then
+ * the samples are skipped.
+ */
+static ENT_ALWAYS_INLINE void
+ent_noise_render_sparse(struct ent_noise *noise,
+                        const struct ent_noise_block *block,
+                        float **data,
+                        size_t size,
+                        enum ent_filter_type filter_type,
+                        bool shelf,
+                        bool stereo)
+{
+        struct qx_fader fader = noise->fader;
+        struct ent_shelf_filter sh_filter_l = noise->sh_filter_l;
+        struct ent_shelf_filter sh_filter_r = noise->sh_filter_r;
+        struct ent_filter filter = noise->filter;
+
+        const float width = block->width;
+        const float gain = block->gain;
+        const float gain_step = block->gain_step;
+        const bool filter_ramp = block->filter_ramp;
+        float *out_l = data[0];
+        float *out_r = data[1];
+
+        const bool filtered = shelf || filter_type != ENT_FILTER_TYPE_ALLPASS;
+        bool ringing = filtered;
+        size_t i = 0;
+        while (i < size) {
+                size_t end = size;
+                const float density = block->density + block->density_step * (float)(i + 1);
+                size_t gap = ent_noise_draw_gap(noise, density);
+                if (gap < size - i)
+                        end = i + gap;
+
+                // Zero input, only the filters ring out. The fade
+                // advances over the whole gap, ringing or not.
+                const size_t start = i;
+                for (; ringing && i < end; i++) {
+                        if (i % 16 == 0
+                            && ent_noise_flush_filters(&sh_filter_l, &sh_filter_r, &filter)) {
+                                ringing = false;
+                                break;
+                        }
+
+                        float l = 0.0f;
+                        float r = 0.0f;
+                        ent_noise_filter_sample(&sh_filter_l, &sh_filter_r, &filter,
+                                                filter_type, filter_ramp, shelf, &l, &r);
+                        const float g = gain + gain_step * (float)(i + 1);
+                        out_l[i] += l * g;
+                        out_r[i] += r * g;
+                }
+
+                qx_fader_skip(&fader, end - start);
+                if (filter_type != ENT_FILTER_TYPE_ALLPASS && filter_ramp)
+                        ent_filter_skip_coeffs(&filter, end - i);
+                i = end;
+                if (i == size)
+                        break;
+
+                // The impulse.
+                float val = qx_random_buffer_next(&noise->values, &noise->randomizer);
+                val = qx_fader_fade(&fader, val);
+
+                float l = val;
+                float r = val;
+                if (stereo) {
+                        const float rand_val = qx_randomizer_get_float(&noise->stereo_randomizer);
+                        if (rand_val < width)
+                                r = 0.0f;
+                        else if (rand_val > 1.0f - width)
+                                l = 0.0f;
+                }
+
+                ent_noise_filter_sample(&sh_filter_l, &sh_filter_r, &filter,
+                                        filter_type, filter_ramp, shelf, &l, &r);
+                const float g = gain + gain_step * (float)(i + 1);
+                out_l[i] += l * g;
+                out_r[i] += r * g;
+                ringing = filtered;
+                i++;
+        }
+
+        noise->fader = fader;
+        noise->sh_filter_l = sh_filter_l;
+        noise->sh_filter_r = sh_filter_r;
+        noise->filter = filter;
+}
+
+static ENT_ALWAYS_INLINE void
+ent_noise_render_mode(struct ent_noise *noise,
+                      const struct ent_noise_block *block,
+                      float **data,
+                      size_t size,
+                      enum ent_noise_type type,
+                      enum ent_filter_type filter_type,
+                      bool shelf,
+                      bool stereo)
+{
+        if (type == ENT_NOISE_TYPE_WHITE && block->sparse)
+                ent_noise_render_sparse(noise, block, data, size, filter_type, shelf, stereo);
+        else
+                ent_noise_render(noise, block, data, size, type, filter_type, shelf, stereo);
+}
+
+static ENT_ALWAYS_INLINE void
+ent_noise_render_filter(struct ent_noise *noise,
+                        const struct ent_noise_block *block,
+                        float **data,
+                        size_t size,
+                        enum ent_noise_type type,
+                        enum ent_filter_type filter_type)
+{
+        const bool shelf = noise->brightness > 1.0e-6f;
+        const bool stereo = block->width > 0.0f;
+        if (shelf && stereo)
+                ent_noise_render_mode(noise, block, data, size, type, filter_type, true, true);
+        else if (shelf)
+                ent_noise_render_mode(noise, block, data, size, type, filter_type, true, false);
+        else if (stereo)
+                ent_noise_render_mode(noise, block, data, size, type, filter_type, false, true);
+        else
+                ent_noise_render_mode(noise, block, data, size, type, filter_type, false, false);
+}
+
+static ENT_ALWAYS_INLINE void
+ent_noise_render_type(struct ent_noise *noise,
+                      const struct ent_noise_block *block,
+                      float **data,
+                      size_t size,
+                      enum ent_noise_type type)
+{
+        switch (noise->filter.type) {
+        case ENT_FILTER_TYPE_LOWPASS:
+                ent_noise_render_filter(noise, block, data, size, type, ENT_FILTER_TYPE_LOWPASS);
+                break;
+        case ENT_FILTER_TYPE_BANDPASS:
+                ent_noise_render_filter(noise, block, data, size, type, ENT_FILTER_TYPE_BANDPASS);
+                break;
+        case ENT_FILTER_TYPE_HIGHPASS:
+                ent_noise_render_filter(noise, block, data, size, type, ENT_FILTER_TYPE_HIGHPASS);
+                break;
+        default: // allpass
+                ent_noise_render_filter(noise, block, data, size, type, ENT_FILTER_TYPE_ALLPASS);
+                break;
+        }
+}
+
+static float ent_noise_density(const struct ent_noise *noise, float entropy)
+{
+        return qx_clamp_float(noise->density * (1.0f + 0.5f * entropy), 0.0f, 1.0f);
+}
+
+static float ent_noise_gain(const struct ent_noise *noise, float entropy)
+{
+        return qx_clamp_float(noise->gain * (1.0f + 0.5f * entropy),
+                              noise->min_gain,
+                              noise->max_gain);
+}
+
+/**
+ * Advances the entropy modulation over the block and computes the
+ * parameters of the block. The density and the gain are interpolated
+ * per sample from their values at the end of the last block to the
+ * values of the current parameters at the entropy of the block end,
+ * the cutoff and the resonance through the filter coefficients. The
+ * parameter changes are thereby ramped over the block.
+ */
+static void ent_noise_begin_block(struct ent_noise *noise,
+                                  struct ent_noise_block *block,
+                                  size_t size)
+{
+        const float entropy = qx_smoother_skip(&noise->entropy, size);
 
         // Modulate filter cutoff
         float cutoff = ent_noise_get_cutoff(noise) * (1.0f + 0.05f * entropy);
@@ -313,67 +747,381 @@ void ent_noise_process(struct ent_noise *noise,
         ent_filter_set_cutoff(&noise->filter, cutoff);
         ent_filter_set_resonance(&noise->filter, resonance);
 
-        // Modulate noise density
-        float density = noise->density * (1.0f + 0.5f * entropy);
-        density = qx_clamp_float(density, 0.0f, 1.0f);
+        // Modulate noise density and gain
+        const float density_start = noise->density_end;
+        const float density = ent_noise_density(noise, entropy);
+        const float gain_start = noise->gain_end;
+        const float gain = ent_noise_gain(noise, entropy);
+        const float inv_size = 1.0f / (float)size;
+        noise->density_end = density;
+        noise->gain_end = gain;
+
+        block->density = density_start;
+        block->density_step = (density - density_start) * inv_size;
+        block->threshold = 2.0f * density_start - 1.0f;
+        block->threshold_step = 2.0f * block->density_step;
+        block->sparse = QX_MAX(density_start, density) <= ENT_NOISE_SPARSE_DENSITY;
+        block->width = noise->stereo / 2.0f;
+        block->gain = gain_start;
+        block->gain_step = (gain - gain_start) * inv_size;
+        block->filter_ramp = ent_filter_ramp(&noise->filter, size);
+}
+
+static void ent_noise_render_block(struct ent_noise *noise,
+                                   const struct ent_noise_block *block,
+                                   float **data,
+                                   size_t size)
+{
+        switch (noise->type) {
+        case ENT_NOISE_TYPE_PINK:
+                ent_noise_render_type(noise, block, data, size, ENT_NOISE_TYPE_PINK);
+                break;
+        case ENT_NOISE_TYPE_BROWN:
+                ent_noise_render_type(noise, block, data, size, ENT_NOISE_TYPE_BROWN);
+                break;
+        default: // white
+                ent_noise_render_type(noise, block, data, size, ENT_NOISE_TYPE_WHITE);
+                break;
+        }
+}
+
+void ent_noise_process(struct ent_noise *noise,
+                       float **data,
+                       size_t size)
+{
+        struct ent_noise_block block;
+        ent_noise_begin_block(noise, &block, size);
+        ent_noise_render_block(noise, &block, data, size);
+}
 
-        const float threshold = 2.0f * density - 1.0f;
+#if defined(__SSE2__)
+/**
+ * Generates the noise of a block before the filters, into the lanes of
+ * the bank. The left and right channels are at lanes[4 * i] and
+ * lanes[4 * i + 1]. The block threshold is the one before the first
+ * sample of the generated samples.
+ */
+static ENT_ALWAYS_INLINE void
+ent_noise_generate(struct ent_noise *noise,
+                   const struct ent_noise_block *block,
+                   float *lanes,
+                   size_t size,
+                   enum ent_noise_type type,
+                   bool stereo)
+{
+        struct qx_fader fader = noise->fader;
+        float pink[3] = {noise->b0, noise->b1, noise->b2};
+        float brown = noise->brown;
+
+        float threshold = block->threshold;
+        const float threshold_step = block->threshold_step;
+        const float width = block->width;
+
+        float prob_values[QX_RANDOM_BUFFER_SIZE];
+        float stereo_values[QX_RANDOM_BUFFER_SIZE];
         for (size_t i = 0; i < size; i++) {
-                float val = 0.0f;
-                const float prob = qx_randomizer_get_float(&noise->prob_randomizer);
-                if (prob <= threshold)
-                        val = qx_randomizer_get_float(&noise->randomizer);
-
-                switch (noise->type) {
-                case ENT_NOISE_TYPE_PINK:
-                        val = pink_from_white(noise, val);
-                        break;
-                case ENT_NOISE_TYPE_BROWN:
-                        val = brown_from_white(noise, val);
-                        break;
-                default: // white
-                        break;
+                threshold += threshold_step;
+
+                const size_t tile_pos = i % QX_RANDOM_BUFFER_SIZE;
+                if (tile_pos == 0) {
+                        size_t n = size - i;
+                        if (n > QX_RANDOM_BUFFER_SIZE)
+                                n = QX_RANDOM_BUFFER_SIZE;
+                        qx_randomizer_fill(&noise->prob_randomizer, prob_values, n);
+                        if (stereo)
+                                qx_randomizer_fill(&noise->stereo_randomizer, stereo_values, n);
                 }
 
-                val = qx_fader_fade(&noise->fader, val);
-
-                // Calculate random stereo channel
-                const float rand_val = qx_randomizer_get_float(&noise->stereo_randomizer);
-                const float width = noise->stereo / 2.0f;
-                if (rand_val < width) {
-                        noise->buffer[0][i] = val;
-                        noise->buffer[1][i] = 0.0f;
-                } else if (rand_val > 1.0f - width) {
-                        noise->buffer[0][i] = 0.0f;
-                        noise->buffer[1][i] = val;
-                } else {
-                        noise->buffer[0][i] = val;
-                        noise->buffer[1][i] = val;
-                }
+                ent_noise_source_sample(noise, &fader, pink, &brown, threshold, width,
+                                        prob_values[tile_pos],
+                                        stereo ? stereo_values[tile_pos] : 0.0f,
+                                        type, stereo,
+                                        &lanes[ENT_NOISE_BANK_LANES * i],
+                                        &lanes[ENT_NOISE_BANK_LANES * i + 1]);
+        }
+
+        noise->fader = fader;
+        noise->b0 = pink[0];
+        noise->b1 = pink[1];
+        noise->b2 = pink[2];
+        noise->brown = brown;
+}
+
+static void ent_noise_generate_block(struct ent_noise *noise,
+                                     const struct ent_noise_block *block,
+                                     float *lanes,
+                                     size_t size)
+{
+        const bool stereo = block->width > 0.0f;
+        switch (noise->type) {
+        case ENT_NOISE_TYPE_PINK:
+                if (stereo)
+                        ent_noise_generate(noise, block, lanes, size, ENT_NOISE_TYPE_PINK, true);
+                else
+                        ent_noise_generate(noise, block, lanes, size, ENT_NOISE_TYPE_PINK, false);
+                break;
+        case ENT_NOISE_TYPE_BROWN:
+                if (stereo)
+                        ent_noise_generate(noise, block, lanes, size, ENT_NOISE_TYPE_BROWN, true);
+                else
+                        ent_noise_generate(noise, block, lanes, size, ENT_NOISE_TYPE_BROWN, false);
+                break;
+        default: // white
+                if (stereo)
+                        ent_noise_generate(noise, block, lanes, size, ENT_NOISE_TYPE_WHITE, true);
+                else
+                        ent_noise_generate(noise, block, lanes, size, ENT_NOISE_TYPE_WHITE, false);
+                break;
         }
+}
+
+/**
+ * The filters state and coefficients of the bank noises in
+ * struct-of-arrays form, noise k has the lanes 2k and 2k + 1. A lane
+ * without shelf has the identity coefficients, a lane without filter
+ * has zero coefficients, which leave the state unchanged, and selects
+ * the filter input as output.
+ */
+struct ent_noise_bank {
+        float b0[ENT_NOISE_BANK_LANES];
+        float b1[ENT_NOISE_BANK_LANES];
+        float b2[ENT_NOISE_BANK_LANES];
+        float a1[ENT_NOISE_BANK_LANES];
+        float a2[ENT_NOISE_BANK_LANES];
+        float z1[ENT_NOISE_BANK_LANES];
+        float z2[ENT_NOISE_BANK_LANES];
+        float g[ENT_NOISE_BANK_LANES];
+        float k[ENT_NOISE_BANK_LANES];
+        float g_step[ENT_NOISE_BANK_LANES];
+        float k_step[ENT_NOISE_BANK_LANES];
+        float inv_denom[ENT_NOISE_BANK_LANES];
+        float ic1eq[ENT_NOISE_BANK_LANES];
+        float ic2eq[ENT_NOISE_BANK_LANES];
+        // Output selection masks.
+        uint32_t lowpass[ENT_NOISE_BANK_LANES];
+        uint32_t bandpass[ENT_NOISE_BANK_LANES];
+        uint32_t highpass[ENT_NOISE_BANK_LANES];
+        uint32_t allpass[ENT_NOISE_BANK_LANES];
+        float min[ENT_NOISE_BANK_LANES];
+        float max[ENT_NOISE_BANK_LANES];
+        float gain[ENT_NOISE_BANK_LANES];
+        float gain_step[ENT_NOISE_BANK_LANES];
+};
 
+static void ent_noise_bank_load(struct ent_noise_bank *bank,
+                                size_t lane,
+                                const struct ent_noise *noise,
+                                const struct ent_noise_block *block)
+{
+        const struct ent_shelf_filter *shelves[2] = {&noise->sh_filter_l, &noise->sh_filter_r};
+        const struct ent_filter *filter = &noise->filter;
+        const bool shelf = noise->brightness > 1.0e-6f;
+        const enum ent_filter_type type = filter->type;
+        for (size_t ch = 0; ch < 2; ch++, lane++) {
+                const struct ent_shelf_filter *sh = shelves[ch];
+                bank->b0[lane] = shelf ? sh->b0 : 1.0f;
+                bank->b1[lane] = shelf ? sh->b1 : 0.0f;
+                bank->b2[lane] = shelf ? sh->b2 : 0.0f;
+                bank->a1[lane] = shelf ? sh->a1 : 0.0f;
+                bank->a2[lane] = shelf ? sh->a2 : 0.0f;
+                bank->z1[lane] = shelf ? sh->z1 : 0.0f;
+                bank->z2[lane] = shelf ? sh->z2 : 0.0f;
+
+                const bool filtered = type != ENT_FILTER_TYPE_ALLPASS;
+                bank->g[lane] = filtered ? filter->g : 0.0f;
+                bank->k[lane] = filtered ? filter->k : 0.0f;
+                bank->g_step[lane] = filtered ? filter->g_step : 0.0f;
+                bank->k_step[lane] = filtered ? filter->k_step : 0.0f;
+                bank->inv_denom[lane] = filtered ? filter->inv_denom : 1.0f;
+                bank->ic1eq[lane] = filtered ? filter->ic1eq[ch] : 0.0f;
+                bank->ic2eq[lane] = filtered ? filter->ic2eq[ch] : 0.0f;
+                bank->lowpass[lane] = type == ENT_FILTER_TYPE_LOWPASS ? UINT32_MAX : 0;
+                bank->bandpass[lane] = type == ENT_FILTER_TYPE_BANDPASS ? UINT32_MAX : 0;
+                bank->highpass[lane] = type == ENT_FILTER_TYPE_HIGHPASS ? UINT32_MAX : 0;
+                bank->allpass[lane] = filtered ? 0 : UINT32_MAX;
+                bank->min[lane] = filtered ? -1.0f : -FLT_MAX;
+                bank->max[lane] = filtered ? 1.0f : FLT_MAX;
+                bank->gain[lane] = block->gain;
+                bank->gain_step[lane] = block->gain_step;
+        }
+}
+
+static void ent_noise_bank_store(const struct ent_noise_bank *bank,
+                                 size_t lane,
+                                 struct ent_noise *noise)
+{
+        struct ent_shelf_filter *shelves[2] = {&noise->sh_filter_l, &noise->sh_filter_r};
+        struct ent_filter *filter = &noise->filter;
         if (noise->brightness > 1.0e-6f) {
-                ent_shelf_filter_process(&noise->sh_filter_l, noise->buffer[0], size);
-                ent_shelf_filter_process(&noise->sh_filter_r, noise->buffer[1], size);
+                for (size_t ch = 0; ch < 2; ch++) {
+                        shelves[ch]->z1 = bank->z1[lane + ch];
+                        shelves[ch]->z2 = bank->z2[lane + ch];
+                }
+        }
+
+        if (filter->type != ENT_FILTER_TYPE_ALLPASS) {
+                filter->g = bank->g[lane];
+                filter->k = bank->k[lane];
+                filter->inv_denom = bank->inv_denom[lane];
+                for (size_t ch = 0; ch < 2; ch++) {
+                        filter->ic1eq[ch] = bank->ic1eq[lane + ch];
+                        filter->ic2eq[ch] = bank->ic2eq[lane + ch];
+                }
+        }
+}
+
+/**
+ * Runs the lanes through the shelf and the filter and applies the gain,
+ * the same operations as ent_noise_filter_sample() on all lanes at once.
+ */
+static void ent_noise_bank_filter(struct ent_noise_bank *bank,
+                                  float *lanes,
+                                  size_t size)
+{
+        const __m128 b0 = _mm_loadu_ps(bank->b0);
+        const __m128 b1 = _mm_loadu_ps(bank->b1);
+        const __m128 b2 = _mm_loadu_ps(bank->b2);
+        const __m128 a1 = _mm_loadu_ps(bank->a1);
+        const __m128 a2 = _mm_loadu_ps(bank->a2);
+        const __m128 g_step = _mm_loadu_ps(bank->g_step);
+        const __m128 k_step = _mm_loadu_ps(bank->k_step);
+        const __m128 lowpass = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)bank->lowpass));
+        const __m128 bandpass = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)bank->bandpass));
+        const __m128 highpass = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)bank->highpass));
+        const __m128 allpass = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)bank->allpass));
+        const __m128 min = _mm_loadu_ps(bank->min);
+        const __m128 max = _mm_loadu_ps(bank->max);
+        const __m128 gain_step = _mm_loadu_ps(bank->gain_step);
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 two = _mm_set1_ps(2.0f);
+        const bool ramp = _mm_movemask_ps(_mm_or_ps(_mm_cmpneq_ps(g_step, _mm_setzero_ps()),
+                                                    _mm_cmpneq_ps(k_step, _mm_setzero_ps())));
+
+        __m128 z1 = _mm_loadu_ps(bank->z1);
+        __m128 z2 = _mm_loadu_ps(bank->z2);
+        __m128 g = _mm_loadu_ps(bank->g);
+        __m128 k = _mm_loadu_ps(bank->k);
+        __m128 inv_denom = _mm_loadu_ps(bank->inv_denom);
+        __m128 ic1eq = _mm_loadu_ps(bank->ic1eq);
+        __m128 ic2eq = _mm_loadu_ps(bank->ic2eq);
+        __m128 gain = _mm_loadu_ps(bank->gain);
+        for (size_t i = 0; i < size; i++) {
+                const __m128 in = _mm_loadu_ps(lanes + ENT_NOISE_BANK_LANES * i);
+
+                // Brightness shelf.
+                const __m128 v0 = _mm_add_ps(_mm_mul_ps(b0, in), z1);
+                z1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1, in), _mm_mul_ps(a1, v0)), z2);
+                z2 = _mm_sub_ps(_mm_mul_ps(b2, in), _mm_mul_ps(a2, v0));
+
+                // Low, band, high pass filter.
+                if (ramp) {
+                        g = _mm_add_ps(g, g_step);
+                        k = _mm_add_ps(k, k_step);
+                        inv_denom = _mm_div_ps(one, _mm_add_ps(one, _mm_mul_ps(g, _mm_add_ps(g, k))));
+                }
+                const __m128 v1 = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(v0, _mm_mul_ps(k, ic1eq)), ic2eq),
+                                             inv_denom);
+                const __m128 v2 = _mm_add_ps(ic1eq, _mm_mul_ps(g, v1));
+                const __m128 v3 = _mm_add_ps(ic2eq, _mm_mul_ps(g, v2));
+                ic1eq = _mm_sub_ps(_mm_mul_ps(two, v2), ic1eq);
+                ic2eq = _mm_sub_ps(_mm_mul_ps(two, v3), ic2eq);
+                const __m128 hp = _mm_sub_ps(_mm_sub_ps(v0, _mm_mul_ps(k, v2)), v3);
+
+                __m128 out = _mm_or_ps(_mm_or_ps(_mm_and_ps(lowpass, v3),
+                                                 _mm_and_ps(bandpass, v2)),
+                                       _mm_or_ps(_mm_and_ps(highpass, hp),
+                                                 _mm_and_ps(allpass, v0)));
+                out = _mm_max_ps(_mm_min_ps(out, max), min);
+                gain = _mm_add_ps(gain, gain_step);
+                _mm_storeu_ps(lanes + ENT_NOISE_BANK_LANES * i, _mm_mul_ps(out, gain));
+        }
+
+        _mm_storeu_ps(bank->z1, z1);
+        _mm_storeu_ps(bank->z2, z2);
+        _mm_storeu_ps(bank->g, g);
+        _mm_storeu_ps(bank->k, k);
+        _mm_storeu_ps(bank->inv_denom, inv_denom);
+        _mm_storeu_ps(bank->ic1eq, ic1eq);
+        _mm_storeu_ps(bank->ic2eq, ic2eq);
+        _mm_storeu_ps(bank->gain, gain);
+}
+
+/**
+ * Renders the noises of the bank together, the noise generation runs
+ * per noise and the filters of the four channels run in SIMD lanes.
+ */
+static void ent_noise_render_bank(struct ent_noise **noises,
+                                  const struct ent_noise_block *blocks,
+                                  float **data,
+                                  size_t size)
+{
+        struct ent_noise_bank bank;
+        struct ent_noise_block chunk_blocks[ENT_NOISE_BANK_SIZE];
+        for (size_t n = 0; n < ENT_NOISE_BANK_SIZE; n++) {
+                ent_noise_bank_load(&bank, 2 * n, noises[n], &blocks[n]);
+                chunk_blocks[n] = blocks[n];
+        }
 
-                const float k = 1.0f / powf(10.0f, noise->sh_filter_r.gain / 20.0f);
-                for (size_t i = 0; i < size; i++) {
-                        noise->buffer[0][i] *= k;
-                        noise->buffer[1][i] *= k;
+        float lanes[ENT_NOISE_BANK_LANES * ENT_NOISE_BANK_CHUNK];
+        float *out_l = data[0];
+        float *out_r = data[1];
+        for (size_t pos = 0; pos < size; pos += ENT_NOISE_BANK_CHUNK) {
+                const size_t chunk = QX_MIN(size - pos, ENT_NOISE_BANK_CHUNK);
+                for (size_t n = 0; n < ENT_NOISE_BANK_SIZE; n++) {
+                        struct ent_noise_block *block = &chunk_blocks[n];
+                        ent_noise_generate_block(noises[n], block, lanes + 2 * n, chunk);
+                        block->threshold += block->threshold_step * (float)chunk;
+                }
+
+                ent_noise_bank_filter(&bank, lanes, chunk);
+
+                // Added in the order of the separate processing.
+                for (size_t i = 0; i < chunk; i++) {
+                        const float *lane = lanes + ENT_NOISE_BANK_LANES * i;
+                        out_l[pos + i] += lane[0];
+                        out_r[pos + i] += lane[1];
+                        out_l[pos + i] += lane[2];
+                        out_r[pos + i] += lane[3];
                 }
         }
 
-        float *buffer[2] = { noise->buffer[0], noise->buffer[1] };
-        ent_filter_process(&noise->filter, buffer, size);
+        for (size_t n = 0; n < ENT_NOISE_BANK_SIZE; n++)
+                ent_noise_bank_store(&bank, 2 * n, noises[n]);
+}
+#endif // __SSE2__
 
-        float gain = noise->gain * (1.0f + 0.5f * entropy);
-        gain = qx_clamp_float(gain,
-                              noise->min_gain,
-                              noise->max_gain);
+void ent_noise_process_bank(struct ent_noise *noises[ENT_NOISE_BANK_SIZE],
+                            float **data,
+                            size_t size)
+{
+        // Without filters the separate processing is faster, the
+        // shelves and the noise generation are fused there.
+        struct ent_noise_block blocks[ENT_NOISE_BANK_SIZE];
+        bool bank = true;
+        bool filtered = false;
+        for (size_t n = 0; n < ENT_NOISE_BANK_SIZE; n++) {
+                if (!ent_noise_is_enabled(noises[n])) {
+                        bank = false;
+                        continue;
+                }
+                ent_noise_begin_block(noises[n], &blocks[n], size);
+                bank = bank && !blocks[n].sparse;
+                filtered = filtered || noises[n]->filter.type != ENT_FILTER_TYPE_ALLPASS;
+        }
+        bank = bank && filtered;
 
-        for (size_t i = 0; i < size; i++) {
-                data[0][i] += noise->buffer[0][i] * gain;
-                data[1][i] += noise->buffer[1][i] * gain;
+#if defined(__SSE2__)
+        if (bank) {
+                ent_noise_render_bank(noises, blocks, data, size);
+                return;
+        }
+#else
+        (void)bank;
+#endif
+
+        for (size_t n = 0; n < ENT_NOISE_BANK_SIZE; n++) {
+                if (ent_noise_is_enabled(noises[n]))
+                        ent_noise_render_block(noises[n], &blocks[n], data, size);
         }
 }
 
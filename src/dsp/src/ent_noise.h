@@ -34,6 +34,9 @@ extern "C" {
 #define ENT_NOISE_MIN_GAIN  (-50.0f) // dB
 #define ENT_NOISE_MAX_GAIN  (6.0f)   // dB
 
+// Number of noises processed together by ent_noise_process_bank().
+#define ENT_NOISE_BANK_SIZE 2
+
 enum ent_noise_type {
         ENT_NOISE_TYPE_WHITE,
         ENT_NOISE_TYPE_PINK,
@@ -45,8 +48,28 @@ struct ent_state_noise;
 
 struct ent_noise* ent_noise_create(int sample_rate);
 
+/**
+ * Returns the size of the module, used to place it in memory
+ * provided by the caller with ent_noise_init().
+ */
+size_t ent_noise_size(void);
+
+struct ent_noise* ent_noise_init(void *mem, int sample_rate);
+
 void ent_noise_free(struct ent_noise **noise);
 
+/**
+ * Prepares the data shared by the noise modules for the sample rate.
+ * Not real-time safe, called before the rate is applied.
+ */
+void ent_noise_prepare(int sample_rate);
+
+/**
+ * Updates the sample rate dependent state. Doesn't allocate,
+ * can be called from the audio thread.
+ */
+void ent_noise_set_sample_rate(struct ent_noise *noise, int sample_rate);
+
 enum ent_error
 ent_noise_enable(struct ent_noise *noise, bool b);
 
@@ -95,11 +118,27 @@ enum ent_error ent_noise_set_resonance(struct ent_noise *noise, float resonance)
 
 float ent_noise_get_resonance(const struct ent_noise *noise);
 
+/**
+ * Adds the noise to data, generating and filtering it in a single pass.
+ */
 void ent_noise_process(struct ent_noise *noise,
                        float **data,
                        size_t size);
 
-void ent_noise_set_entropy(struct ent_noise *noise, float entropy);
+/**
+ * Adds the enabled noises to data. If all are enabled, dense and at
+ * least one is filtered, their channels are filtered together in SIMD
+ * lanes, otherwise each noise is processed separately.
+ */
+void ent_noise_process_bank(struct ent_noise *noises[ENT_NOISE_BANK_SIZE],
+                            float **data,
+                            size_t size);
+
+/**
+ * Ramps the entropy linearly to the given value over the next frames
+ * samples. The cutoff, resonance, density and gain follow it per sample.
+ */
+void ent_noise_set_entropy(struct ent_noise *noise, float entropy, size_t frames);
 
 float ent_noise_get_entropy(const struct ent_noise *noise);
 
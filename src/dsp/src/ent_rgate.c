@@ -24,10 +24,16 @@
 #include "ent_rgate.h"
 #include "ent_log.h"
 #include "qx_math.h"
-#include "qx_smoother.h"
 #include "qx_randomizer.h"
 #include "ent_state_internal.h"
 
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The gain ramps to each new target over this many samples.
+#define ENT_RGATE_RAMP_SAMPLES 400
+
 struct ent_rgate {
         // Parameters
         bool enabled;
@@ -47,23 +53,56 @@ struct ent_rgate {
         struct qx_randomizer randomizer_interval;
         struct qx_randomizer randomizer_duration;
         struct qx_randomizer randomizer_gain;
-        struct qx_smoother current_gain;
-        float timer_ms;
-        float duration;
-        float ms_per_sample;
+        // The gate is held at the drawn gain until the countdown ends.
+        bool closed;
+        // Samples to render before the next state change.
+        size_t countdown;
+        // The interval drawn when the gate closed, it starts
+        // counting when the gate opens again.
+        size_t next_interval;
+        float gain;
+        float gain_target;
+        float gain_step;
+        // Samples left of the ramp before the target gain.
+        size_t ramp_left;
         float interval_range;
         float duration_range;
         float gain_range;
 };
 
-struct ent_rgate* ent_rgate_create(int sample_rate)
+/**
+ * Returns the number of samples of a time in ms, rounded up. The
+ * tolerance keeps exact times (e.g. 5 ms at 48 kHz) on their sample
+ * count despite the float rounding.
+ */
+static size_t ent_rgate_ms_to_samples(const struct ent_rgate *g, float ms)
 {
-        struct ent_rgate* g = calloc(1, sizeof(struct ent_rgate));
-        if (!g)
-                return NULL;
+        float samples = ceilf(ms * (float)g->sample_rate / 1000.0f - 1e-3f);
+        return samples > 0.0f ? (size_t)samples : 0;
+}
+
+/**
+ * Starts a ramp to the target. The last sample of the ramp is the
+ * target itself, so it's rendered as constant and can't overshoot.
+ */
+static void ent_rgate_set_target(struct ent_rgate *g, float target)
+{
+        g->gain_target = target;
+        g->gain_step = (target - g->gain) / ENT_RGATE_RAMP_SAMPLES;
+        g->ramp_left = (target != g->gain) ? ENT_RGATE_RAMP_SAMPLES - 1 : 0;
+}
+
+size_t ent_rgate_size(void)
+{
+        return sizeof(struct ent_rgate);
+}
+
+struct ent_rgate* ent_rgate_init(void *mem, int sample_rate)
+{
+        struct ent_rgate* g = mem;
+        memset(g, 0, sizeof(struct ent_rgate));
 
         g->sample_rate = sample_rate;
-        g->ms_per_sample = 1000.0f / g->sample_rate;
 
         // Default parameters
         g->enabled = false;
@@ -85,14 +124,26 @@ struct ent_rgate* ent_rgate_create(int sample_rate)
         qx_randomizer_init(&g->randomizer_interval, 0.0f, 1.0f, 1.0f / 65536.0f);
         qx_randomizer_init(&g->randomizer_duration, 0.0f, 1.0f, 1.0f / 65536.0f);
         qx_randomizer_init(&g->randomizer_gain, 0.0f, 1.0f, 1.0f / 65536.0f);
-        qx_smoother_init(&g->current_gain, ENT_RGATE_DEFAULT_MIN_GAIN, 400.0f);
 
-        g->timer_ms = g->min_interval;
-        g->duration = g->min_duration;
+        // Starts closed at the minimum gain.
+        g->gain = ENT_RGATE_DEFAULT_MIN_GAIN;
+        g->gain_target = g->gain;
+        g->closed = true;
+        g->countdown = ent_rgate_ms_to_samples(g, g->min_duration);
+        g->next_interval = QX_MAX(ent_rgate_ms_to_samples(g, g->min_interval), 1);
 
         return g;
 }
 
+struct ent_rgate* ent_rgate_create(int sample_rate)
+{
+        struct ent_rgate* g = malloc(sizeof(struct ent_rgate));
+        if (!g)
+                return NULL;
+
+        return ent_rgate_init(g, sample_rate);
+}
+
 void ent_rgate_free(struct ent_rgate **g)
 {
         if (g && *g) {
@@ -101,6 +152,16 @@ void ent_rgate_free(struct ent_rgate **g)
         }
 }
 
+void ent_rgate_set_sample_rate(struct ent_rgate *g, int sample_rate)
+{
+        // Keep the time left of the current state at the new rate.
+        g->countdown = (size_t)((uint64_t)g->countdown * sample_rate / g->sample_rate);
+        g->next_interval = (size_t)((uint64_t)g->next_interval * sample_rate / g->sample_rate);
+        if (g->next_interval < 1)
+                g->next_interval = 1;
+        g->sample_rate = sample_rate;
+}
+
 enum ent_error ent_rgate_enable(struct ent_rgate *g, bool enable)
 {
         g->enabled = enable;
@@ -114,9 +175,9 @@ bool ent_rgate_is_enabled(const struct ent_rgate *g)
 
 enum ent_error ent_rgate_set_min_interval(struct ent_rgate *g, float val)
 {
-        g->min_duration = qx_clamp_float(val,
-                                         ENT_RGATE_MIN_MIN_DURATION,
-                                         ENT_RGATE_MAX_MIN_DURATION);
+        g->min_interval = qx_clamp_float(val,
+                                         ENT_RGATE_MIN_MIN_INTERVAL,
+                                         ENT_RGATE_MAX_MIN_INTERVAL);
         g->interval_range = fabs(g->max_interval - g->min_interval);
         return ENT_OK;
 }
@@ -220,71 +281,119 @@ bool ent_rgate_get_inverted(const struct ent_rgate *g)
         return g->inverted;
 }
 
+/**
+ * Moves the gate to its next state. When open, the interval has ended
+ * and the gate may close for a random duration. When closed, the gate
+ * opens and the interval drawn at closing starts.
+ */
+static void ent_rgate_next_state(struct ent_rgate *g)
+{
+        if (g->closed) {
+                g->closed = false;
+                ent_rgate_set_target(g, 1.0f);
+                // The first open sample counts as part of the interval.
+                g->countdown = g->next_interval - 1;
+                return;
+        }
+
+        // The interval ends on its last sample, it has at least one.
+        float rv = qx_randomizer_get_float(&g->randomizer_interval);
+        size_t interval = ent_rgate_ms_to_samples(g, g->min_interval + g->interval_range * rv);
+        interval = QX_MAX(interval, 1);
+
+        rv = qx_randomizer_get_float(&g->randomizer);
+        if (rv <= g->randomness) {
+                rv = qx_randomizer_get_float(&g->randomizer_duration);
+                float duration = g->min_duration + g->duration_range * rv;
+
+                rv = qx_randomizer_get_float(&g->randomizer_gain);
+                ent_rgate_set_target(g, g->min_gain + g->gain_range * rv);
+
+                // The current sample plus the duration.
+                g->closed = true;
+                g->countdown = 1 + ent_rgate_ms_to_samples(g, duration);
+                g->next_interval = interval;
+        } else {
+                g->countdown = interval;
+        }
+}
+
+static void ent_rgate_mix_constant(float *out_l,
+                                   float *out_r,
+                                   const float *in_l,
+                                   const float *in_r,
+                                   float gain,
+                                   size_t n)
+{
+        for (size_t i = 0; i < n; i++) {
+                out_l[i] += in_l[i] * gain;
+                out_r[i] += in_r[i] * gain;
+        }
+}
+
+/**
+ * Mixes a linear ramp, the gain of the sample i is gain + (i + 1) * step.
+ */
+static void ent_rgate_mix_ramp(float *out_l,
+                               float *out_r,
+                               const float *in_l,
+                               const float *in_r,
+                               float gain,
+                               float step,
+                               size_t n)
+{
+        // An int counter, the conversion of size_t doesn't vectorize.
+        for (int i = 0; i < (int)n; i++) {
+                float v = gain + (float)(i + 1) * step;
+                out_l[i] += in_l[i] * v;
+                out_r[i] += in_r[i] * v;
+        }
+}
+
 void ent_rgate_process(struct ent_rgate *g,
                        float **in,
                        float **out,
                        size_t size)
 {
-        float duration      = g->duration;
-        float timer_ms      = g->timer_ms;
-
-        const float ms_per_sample = g->ms_per_sample;
-        const float randomness    = g->randomness;
-        const float min_interval  = g->min_interval;
-        const float interval_rng  = g->interval_range;
-        const float min_duration  = g->min_duration;
-        const float duration_rng  = g->duration_range;
-        const float min_gain      = g->min_gain;
-        const float gain_rng      = g->gain_range;
-        const bool  inverted      = g->inverted;
-
-        struct qx_smoother   *current_gain  = &g->current_gain;
-        struct qx_randomizer *rand_interval = &g->randomizer_interval;
-        struct qx_randomizer *rand_duration = &g->randomizer_duration;
-        struct qx_randomizer *rand_gain     = &g->randomizer_gain;
-        struct qx_randomizer *rand_main     = &g->randomizer;
-
-        const float *inL  = in[0];
-        const float *inR  = in[1];
-        float *outL = out[0];
-        float *outR = out[1];
-
-        for (size_t i = 0; i < size; i++) {
-                float in_l = inL[i];
-                float in_r = inR[i];
-
-                if (duration > 0.0f) {
-                        duration -= ms_per_sample;
-                } else {
-                        qx_smoother_set_target(current_gain, 1.0f);
-                        timer_ms -= ms_per_sample;
-
-                        if (timer_ms <= 0.0f) {
-                                float rv = qx_randomizer_get_float(rand_interval);
-                                timer_ms = min_interval + interval_rng * rv;
-
-                                rv = qx_randomizer_get_float(rand_main);
-                                if (rv <= randomness) {
-                                        rv = qx_randomizer_get_float(rand_duration);
-                                        duration = min_duration + duration_rng * rv;
-
-                                        rv = qx_randomizer_get_float(rand_gain);
-                                        float new_gain = min_gain + gain_rng * rv;
-
-                                        qx_smoother_set_target(current_gain, new_gain);
-                                }
-                        }
+        const float *in_l = in[0];
+        const float *in_r = in[1];
+        float *out_l = out[0];
+        float *out_r = out[1];
+
+        // The output gain is offset + scale * gain.
+        const float scale  = g->inverted ? -1.0f : 1.0f;
+        const float offset = g->inverted ? 1.0f : 0.0f;
+
+        size_t i = 0;
+        while (i < size) {
+                while (g->countdown == 0)
+                        ent_rgate_next_state(g);
+
+                size_t n = QX_MIN(size - i, g->countdown);
+                g->countdown -= n;
+
+                size_t ramp = QX_MIN(n, g->ramp_left);
+                if (ramp > 0) {
+                        ent_rgate_mix_ramp(out_l + i, out_r + i, in_l + i, in_r + i,
+                                           offset + scale * g->gain,
+                                           scale * g->gain_step,
+                                           ramp);
+                        g->ramp_left -= ramp;
+                        if (g->ramp_left == 0)
+                                g->gain = g->gain_target;
+                        else
+                                g->gain += (float)ramp * g->gain_step;
+                        i += ramp;
+                        n -= ramp;
                 }
 
-                float gain = qx_smoother_next(current_gain);
-                gain = inverted ? 1.0f - gain : gain;
-
-                outL[i] += in_l * gain;
-                outR[i] += in_r * gain;
+                if (n > 0) {
+                        ent_rgate_mix_constant(out_l + i, out_r + i, in_l + i, in_r + i,
+                                               offset + scale * g->gain,
+                                               n);
+                        i += n;
+                }
         }
-
-        g->duration = duration;
-        g->timer_ms = timer_ms;
 }
 
 void ent_rgate_set_state(struct ent_rgate *g, const struct ent_state_rgate *state)
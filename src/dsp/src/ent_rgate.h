@@ -65,8 +65,22 @@ struct ent_state_rgate;
 struct ent_rgate*
 ent_rgate_create(int sample_rate);
 
+/**
+ * Returns the size of the module, used to place it in memory
+ * provided by the caller with ent_rgate_init().
+ */
+size_t ent_rgate_size(void);
+
+struct ent_rgate* ent_rgate_init(void *mem, int sample_rate);
+
 void ent_rgate_free(struct ent_rgate **g);
 
+/**
+ * Updates the sample rate dependent state. Doesn't allocate,
+ * can be called from the audio thread.
+ */
+void ent_rgate_set_sample_rate(struct ent_rgate *g, int sample_rate);
+
 enum ent_error
 ent_rgate_enable(struct ent_rgate *g, bool enable);
 
@@ -23,15 +23,47 @@
 
 #include "ent_shelf_filter.h"
 #include <math.h>
+#include <stdatomic.h>
 
 #include "ent_log.h"
 
-void ent_shelf_filter_init(struct ent_shelf_filter* filter,
-                           float sample_rate,
-                           float cut_off,
-                           float gain)
+// Number of sample rates and curves the designs are cached for at once.
+#define ENT_SHELF_CACHE_SLOTS 8
+
+struct ent_shelf_design {
+        float b0, b1, b2;
+        float a1, a2;
+};
+
+/**
+ * The designs of a curve at a sample rate, one per brightness step,
+ * shared read-only by all instances. A slot is rebuilt for another
+ * curve or rate when it is the least recently used. The version is
+ * odd while the slot is built, the readers check it didn't change
+ * while they copied a design.
+ */
+struct ent_shelf_cache_slot {
+        atomic_uint version;
+        _Atomic(const struct ent_shelf_curve*) curve;
+        atomic_int sample_rate;
+        // The cache clock of the last use.
+        atomic_uint last_used;
+        struct ent_shelf_design designs[ENT_SHELF_BRIGHTNESS_STEPS + 1];
+};
+
+static struct ent_shelf_cache_slot ent_shelf_cache[ENT_SHELF_CACHE_SLOTS];
+static atomic_uint ent_shelf_cache_clock = 1;
+
+/**
+ * RBJ high-shelf design. The normalization gain, if any, scales
+ * the feedforward coefficients.
+ */
+static void ent_shelf_filter_design(struct ent_shelf_design *design,
+                                    float sample_rate,
+                                    float cut_off,
+                                    float gain,
+                                    float norm)
 {
-        filter->gain = gain;
         float A = powf(10.0f, gain / 40.0f);
         float w0 = 2.0f * M_PI * cut_off / sample_rate;
         float cosw0 = cosf(w0);
@@ -46,12 +78,129 @@ void ent_shelf_filter_init(struct ent_shelf_filter* filter,
         float a2 =        (A+1) - (A-1)*cosw0 - 2*sqrtf(A)*alpha;
 
         // Normalize coefficients
-        filter->b0 = b0 / a0;
-        filter->b1 = b1 / a0;
-        filter->b2 = b2 / a0;
-        filter->a1 = a1 / a0;
-        filter->a2 = a2 / a0;
+        design->b0 = norm * b0 / a0;
+        design->b1 = norm * b1 / a0;
+        design->b2 = norm * b2 / a0;
+        design->a1 = a1 / a0;
+        design->a2 = a2 / a0;
+}
+
+static void ent_shelf_filter_set_design(struct ent_shelf_filter* filter,
+                                        const struct ent_shelf_design *design)
+{
+        filter->b0 = design->b0;
+        filter->b1 = design->b1;
+        filter->b2 = design->b2;
+        filter->a1 = design->a1;
+        filter->a2 = design->a2;
+}
+
+static float ent_shelf_curve_gain(const struct ent_shelf_curve *curve, float brightness)
+{
+        return curve->min_gain + (curve->max_gain - curve->min_gain) * brightness;
+}
+
+static void ent_shelf_curve_design(const struct ent_shelf_curve *curve,
+                                   struct ent_shelf_design *design,
+                                   int sample_rate,
+                                   float brightness)
+{
+        const float cutoff = curve->min_cutoff
+                + (curve->max_cutoff - curve->min_cutoff) * brightness;
+        const float gain = ent_shelf_curve_gain(curve, brightness);
+        const float norm = curve->normalize ? 1.0f / powf(10.0f, gain / 20.0f) : 1.0f;
+        ent_shelf_filter_design(design, sample_rate, cutoff, gain, norm);
+}
+
+static bool
+ent_shelf_cache_slot_matches(struct ent_shelf_cache_slot *slot,
+                             const struct ent_shelf_curve *curve,
+                             int sample_rate)
+{
+        return atomic_load_explicit(&slot->curve, memory_order_relaxed) == curve
+                && atomic_load_explicit(&slot->sample_rate, memory_order_relaxed) == sample_rate;
+}
+
+/**
+ * Copies the design of the step from the cache. Returns false if the
+ * curve is not prepared for the sample rate, or the slot is rebuilt
+ * for another one while it's read.
+ */
+static bool ent_shelf_cache_read(const struct ent_shelf_curve *curve,
+                                 int sample_rate,
+                                 size_t step,
+                                 struct ent_shelf_design *design)
+{
+        for (size_t i = 0; i < ENT_SHELF_CACHE_SLOTS; i++) {
+                struct ent_shelf_cache_slot *slot = &ent_shelf_cache[i];
+                unsigned int version = atomic_load_explicit(&slot->version, memory_order_acquire);
+                if (version == 0 || (version & 1)
+                    || !ent_shelf_cache_slot_matches(slot, curve, sample_rate))
+                        continue;
+
+                *design = slot->designs[step];
+                atomic_thread_fence(memory_order_acquire);
+                if (atomic_load_explicit(&slot->version, memory_order_relaxed) != version)
+                        return false;
+
+                atomic_store_explicit(&slot->last_used,
+                                      atomic_fetch_add_explicit(&ent_shelf_cache_clock,
+                                                                1,
+                                                                memory_order_relaxed),
+                                      memory_order_relaxed);
+                return true;
+        }
+        return false;
+}
+
+/**
+ * Returns the slot built for the curve at the sample rate, or NULL.
+ */
+static struct ent_shelf_cache_slot*
+ent_shelf_cache_find(const struct ent_shelf_curve *curve, int sample_rate)
+{
+        for (size_t i = 0; i < ENT_SHELF_CACHE_SLOTS; i++) {
+                struct ent_shelf_cache_slot *slot = &ent_shelf_cache[i];
+                unsigned int version = atomic_load_explicit(&slot->version, memory_order_acquire);
+                if (version != 0 && !(version & 1)
+                    && ent_shelf_cache_slot_matches(slot, curve, sample_rate))
+                        return slot;
+        }
+        return NULL;
+}
+
+/**
+ * Returns the slot never used or used least recently, not being built.
+ */
+static struct ent_shelf_cache_slot* ent_shelf_cache_lru(void)
+{
+        struct ent_shelf_cache_slot *lru = NULL;
+        unsigned int lru_age = 0;
+        const unsigned int now = atomic_load_explicit(&ent_shelf_cache_clock, memory_order_relaxed);
+        for (size_t i = 0; i < ENT_SHELF_CACHE_SLOTS; i++) {
+                struct ent_shelf_cache_slot *slot = &ent_shelf_cache[i];
+                unsigned int version = atomic_load_explicit(&slot->version, memory_order_relaxed);
+                if (version & 1)
+                        continue;
+                if (version == 0)
+                        return slot;
 
+                // The age wraps with the clock.
+                unsigned int age = now - atomic_load_explicit(&slot->last_used, memory_order_relaxed);
+                if (lru == NULL || age > lru_age) {
+                        lru = slot;
+                        lru_age = age;
+                }
+        }
+        return lru;
+}
+
+void ent_shelf_filter_init(struct ent_shelf_filter* filter,
+                           float sample_rate,
+                           float cut_off,
+                           float gain)
+{
+        ent_shelf_filter_set_cutoff(filter, sample_rate, cut_off, gain);
         filter->z1 = 0.0f;
         filter->z2 = 0.0f;
 }
@@ -61,40 +210,74 @@ void ent_shelf_filter_set_cutoff(struct ent_shelf_filter* filter,
                                  float cut_off,
                                  float gain)
 {
+        struct ent_shelf_design design;
+        ent_shelf_filter_design(&design, sample_rate, cut_off, gain, 1.0f);
+        ent_shelf_filter_set_design(filter, &design);
         filter->gain = gain;
-        float A = powf(10.0f, gain / 40.0f);
-        float w0 = 2.0f * M_PI * cut_off / sample_rate;
-        float cosw0 = cosf(w0);
-        float sinw0 = sinf(w0);
-        float alpha = sinw0 / 2.0f * sqrtf((A + 1/A) * 1.0f + 2.0f);
+}
 
-        float b0 =    A * ((A+1) + (A-1)*cosw0 + 2*sqrtf(A)*alpha);
-        float b1 = -2*A * ((A-1) + (A+1)*cosw0);
-        float b2 =    A * ((A+1) + (A-1)*cosw0 - 2*sqrtf(A)*alpha);
-        float a0 =        (A+1) - (A-1)*cosw0 + 2*sqrtf(A)*alpha;
-        float a1 =  2 * ((A-1) - (A+1)*cosw0);
-        float a2 =        (A+1) - (A-1)*cosw0 - 2*sqrtf(A)*alpha;
+void ent_shelf_filter_prepare(const struct ent_shelf_curve *curve,
+                              int sample_rate)
+{
+        // If two instances prepare the same designs at once both may
+        // be built, the lookup uses the first one.
+        struct ent_shelf_cache_slot *slot = ent_shelf_cache_find(curve, sample_rate);
+        for (int retry = 0; slot == NULL && retry < ENT_SHELF_CACHE_SLOTS; retry++) {
+                struct ent_shelf_cache_slot *lru = ent_shelf_cache_lru();
+                if (lru == NULL)
+                        break;
 
-        // Normalize coefficients
-        filter->b0 = b0 / a0;
-        filter->b1 = b1 / a0;
-        filter->b2 = b2 / a0;
-        filter->a1 = a1 / a0;
-        filter->a2 = a2 / a0;
+                unsigned int version = atomic_load_explicit(&lru->version, memory_order_relaxed);
+                if ((version & 1)
+                    || !atomic_compare_exchange_strong(&lru->version, &version, version + 1))
+                        continue;
+
+                atomic_store_explicit(&lru->curve, curve, memory_order_relaxed);
+                atomic_store_explicit(&lru->sample_rate, sample_rate, memory_order_relaxed);
+                atomic_thread_fence(memory_order_release);
+                for (size_t step = 0; step <= ENT_SHELF_BRIGHTNESS_STEPS; step++) {
+                        ent_shelf_curve_design(curve,
+                                               &lru->designs[step],
+                                               sample_rate,
+                                               (float)step / ENT_SHELF_BRIGHTNESS_STEPS);
+                }
+                atomic_store_explicit(&lru->version, version + 2, memory_order_release);
+                slot = lru;
+        }
+
+        if (slot == NULL) {
+                ent_log_debug("shelf designs cache is busy, computing designs");
+                return;
+        }
+
+        // The prepared designs are the last to be evicted.
+        atomic_store_explicit(&slot->last_used,
+                              atomic_fetch_add_explicit(&ent_shelf_cache_clock, 1, memory_order_relaxed),
+                              memory_order_relaxed);
+}
+
+void ent_shelf_filter_set_brightness(struct ent_shelf_filter* filter,
+                                     const struct ent_shelf_curve *curve,
+                                     int sample_rate,
+                                     float brightness)
+{
+        const size_t step = lrintf(qx_clamp_float(brightness, 0.0f, 1.0f)
+                                   * ENT_SHELF_BRIGHTNESS_STEPS);
+        const float quantized = (float)step / ENT_SHELF_BRIGHTNESS_STEPS;
+        filter->gain = ent_shelf_curve_gain(curve, quantized);
+
+        // The designs are computed only if the curve wasn't prepared.
+        struct ent_shelf_design design;
+        if (!ent_shelf_cache_read(curve, sample_rate, step, &design))
+                ent_shelf_curve_design(curve, &design, sample_rate, quantized);
+        ent_shelf_filter_set_design(filter, &design);
 }
 
 void ent_shelf_filter_process(struct ent_shelf_filter* filter,
                               float *data,
                               size_t size)
 {
-        for (size_t i = 0; i < size; ++i) {
-                float in = data[i];
-
-                float out = filter->b0 * in + filter->z1;
-                filter->z1 = filter->b1 * in - filter->a1 * out + filter->z2;
-                filter->z2 = filter->b2 * in - filter->a2 * out;
-
-                data[i] = out;
-        }
+        for (size_t i = 0; i < size; ++i)
+                data[i] = ent_shelf_filter_process_sample(filter, data[i]);
 }
 
@@ -26,8 +26,15 @@
 
 #include "ent_defs.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #include "qx_math.h"
 
+// Number of brightness steps of the shared shelf designs.
+#define ENT_SHELF_BRIGHTNESS_STEPS 512
+
 struct ent_shelf_filter {
         float b0, b1, b2;
         float a1, a2;
@@ -35,6 +42,20 @@ struct ent_shelf_filter {
         float gain;
 };
 
+/**
+ * Maps a brightness in [0, 1] linearly to the shelf cutoff and gain.
+ * If normalize is set, the output is scaled by the inverse of the shelf
+ * gain, folded into the coefficients, so the boost above the cutoff
+ * becomes a cut below it.
+ */
+struct ent_shelf_curve {
+        float min_cutoff;
+        float max_cutoff;
+        // Gain in dB at brightness 0 and 1.
+        float min_gain;
+        float max_gain;
+        bool normalize;
+};
 
 void ent_shelf_filter_init(struct ent_shelf_filter* filter,
                            float sample_rate,
@@ -46,8 +67,43 @@ void ent_shelf_filter_set_cutoff(struct ent_shelf_filter* filter,
                                  float cut_off,
                                  float gain);
 
+/**
+ * Computes the shelf designs of the curve at the sample rate, for
+ * ENT_SHELF_BRIGHTNESS_STEPS steps of the brightness, and keeps them in
+ * a cache shared by all instances. The designs used least recently are
+ * replaced when the cache is full. Not real-time safe, called before
+ * the sample rate is applied.
+ */
+void ent_shelf_filter_prepare(const struct ent_shelf_curve *curve,
+                              int sample_rate);
+
+/**
+ * Sets the coefficients of the brightness rounded to the nearest step,
+ * from the shared cache if the curve was prepared for the sample rate,
+ * otherwise computed.
+ */
+void ent_shelf_filter_set_brightness(struct ent_shelf_filter* filter,
+                                     const struct ent_shelf_curve *curve,
+                                     int sample_rate,
+                                     float brightness);
+
 void ent_shelf_filter_process(struct ent_shelf_filter* filter,
                               float *data,
                               size_t size);
 
+/**
+ * Processes one sample, for fused processing loops.
+ */
+static ENT_ALWAYS_INLINE float
+ent_shelf_filter_process_sample(struct ent_shelf_filter* filter, float in)
+{
+        float out = filter->b0 * in + filter->z1;
+        filter->z1 = filter->b1 * in - filter->a1 * out + filter->z2;
+        filter->z2 = filter->b2 * in - filter->a2 * out;
+        return out;
+}
+
+#ifdef __cplusplus
+}
+#endif
 #endif // ENT_SHELF_FILTER_H
@@ -292,6 +292,16 @@ float ent_state_crackle_get_stereo_spread(const struct ent_state_crackle *c)
     return atomic_load_explicit(&c->stereo_spread, memory_order_relaxed);
 }
 
+void ent_state_crackle_set_voices(struct ent_state_crackle *c, int voices)
+{
+    atomic_store_explicit(&c->voices, voices, memory_order_relaxed);
+}
+
+int ent_state_crackle_get_voices(const struct ent_state_crackle *c)
+{
+    return atomic_load_explicit(&c->voices, memory_order_relaxed);
+}
+
 /* GLITCH */
 void ent_state_glitch_set_enabled(struct ent_state_glitch *g, bool enabled)
 {
@@ -373,6 +383,38 @@ float ent_state_glitch_get_wet(const struct ent_state_glitch *g)
     return atomic_load_explicit(&g->wet, memory_order_relaxed);
 }
 
+void ent_state_glitch_set_crossfade(struct ent_state_glitch *g, float crossfade)
+{
+    atomic_store_explicit(&g->crossfade, crossfade, memory_order_relaxed);
+}
+
+float ent_state_glitch_get_crossfade(const struct ent_state_glitch *g)
+{
+    return atomic_load_explicit(&g->crossfade, memory_order_relaxed);
+}
+
+void ent_state_glitch_set_speed(struct ent_state_glitch *g, float speed)
+{
+    atomic_store_explicit(&g->speed, speed, memory_order_relaxed);
+}
+
+float ent_state_glitch_get_speed(const struct ent_state_glitch *g)
+{
+    return atomic_load_explicit(&g->speed, memory_order_relaxed);
+}
+
+void ent_state_glitch_set_interpolation(struct ent_state_glitch *g, int interpolation)
+{
+    atomic_store_explicit(&g->interpolation,
+                          (enum ent_glitch_interpolation)interpolation,
+                          memory_order_relaxed);
+}
+
+int ent_state_glitch_get_interpolation(const struct ent_state_glitch *g)
+{
+    return atomic_load_explicit(&g->interpolation, memory_order_relaxed);
+}
+
 /* RGATE */
 void ent_state_rgate_set_enabled(struct ent_state_rgate *g, bool val)
 {
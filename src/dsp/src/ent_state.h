@@ -129,6 +129,9 @@ int  ent_state_crackle_get_envelope_shape(const struct ent_state_crackle *c);
 void ent_state_crackle_set_stereo_spread(struct ent_state_crackle *c, float spread);
 float ent_state_crackle_get_stereo_spread(const struct ent_state_crackle *c);
 
+void ent_state_crackle_set_voices(struct ent_state_crackle *c, int voices);
+int ent_state_crackle_get_voices(const struct ent_state_crackle *c);
+
 /* GLITCH */
 void ent_state_glitch_set_enabled(struct ent_state_glitch *g, bool enabled);
 bool ent_state_glitch_get_enabled(const struct ent_state_glitch *g);
@@ -154,6 +157,15 @@ float ent_state_glitch_get_dry(const struct ent_state_glitch *g);
 void ent_state_glitch_set_wet(struct ent_state_glitch *g, float wet);
 float ent_state_glitch_get_wet(const struct ent_state_glitch *g);
 
+void ent_state_glitch_set_crossfade(struct ent_state_glitch *g, float crossfade);
+float ent_state_glitch_get_crossfade(const struct ent_state_glitch *g);
+
+void ent_state_glitch_set_speed(struct ent_state_glitch *g, float speed);
+float ent_state_glitch_get_speed(const struct ent_state_glitch *g);
+
+void ent_state_glitch_set_interpolation(struct ent_state_glitch *g, int interpolation);
+int  ent_state_glitch_get_interpolation(const struct ent_state_glitch *g);
+
 /* RGATE */
 void ent_state_rgate_set_enabled(struct ent_state_rgate *g, bool val);
 bool ent_state_rgate_get_enabled(const struct ent_state_rgate *g);
@@ -49,6 +49,7 @@ struct ent_state_crackle {
         _Atomic(float) brightness;
         _Atomic(enum ent_crackle_envelope) envelope_shape;
         _Atomic(float) stereo_spread;
+        _Atomic(int) voices;
 };
 
 struct ent_state_glitch {
@@ -60,6 +61,9 @@ struct ent_state_glitch {
         _Atomic(int) repeats;
         _Atomic(float) dry;
         _Atomic(float) wet;
+        _Atomic(float) crossfade;
+        _Atomic(float) speed;
+        _Atomic(enum ent_glitch_interpolation) interpolation;
 };
 
 struct ent_state_rgate {
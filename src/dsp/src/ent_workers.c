@@ -0,0 +1,191 @@
+/**
+ * File name: ent_workers.c
+ * Project: Entropictron (A texture synthesizer)
+ *
+ * Copyright (C) 2025 Iurie Nistor
+ *
+ * This file is part of Entropictron.
+ *
+ * Entropictron is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef ENTROPICTRON_OS_WINDOWS
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "ent_workers.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+struct ent_workers {
+        pthread_t *threads;
+        size_t count;
+
+        // The batch, written under the mutex.
+        pthread_mutex_t mutex;
+        pthread_cond_t start_cond;
+        pthread_cond_t done_cond;
+        unsigned long batch;
+        bool quit;
+        ent_workers_task task;
+        void *data;
+        size_t num_tasks;
+        // Number of threads done with the current batch.
+        size_t finished;
+
+        atomic_size_t next_task;
+};
+
+/**
+ * Runs the unclaimed tasks of the current batch.
+ */
+static void
+ent_workers_claim_tasks(struct ent_workers *workers,
+                        ent_workers_task task,
+                        void *data,
+                        size_t num_tasks)
+{
+        for (;;) {
+                size_t index = atomic_fetch_add_explicit(&workers->next_task,
+                                                         1,
+                                                         memory_order_relaxed);
+                if (index >= num_tasks)
+                        return;
+                task(data, index);
+        }
+}
+
+static void* ent_workers_thread(void *arg)
+{
+        struct ent_workers *workers = arg;
+        unsigned long batch = 0;
+
+        pthread_mutex_lock(&workers->mutex);
+        for (;;) {
+                while (!workers->quit && workers->batch == batch)
+                        pthread_cond_wait(&workers->start_cond, &workers->mutex);
+                if (workers->quit)
+                        break;
+
+                batch = workers->batch;
+                ent_workers_task task = workers->task;
+                void *data = workers->data;
+                size_t num_tasks = workers->num_tasks;
+                pthread_mutex_unlock(&workers->mutex);
+
+                ent_workers_claim_tasks(workers, task, data, num_tasks);
+
+                // The batch ends when all the threads are done with it,
+                // so no thread can claim a task of the next batch.
+                pthread_mutex_lock(&workers->mutex);
+                if (++workers->finished == workers->count)
+                        pthread_cond_signal(&workers->done_cond);
+        }
+        pthread_mutex_unlock(&workers->mutex);
+
+        return NULL;
+}
+
+static void ent_workers_stop(struct ent_workers *workers, size_t started)
+{
+        pthread_mutex_lock(&workers->mutex);
+        workers->quit = true;
+        pthread_cond_broadcast(&workers->start_cond);
+        pthread_mutex_unlock(&workers->mutex);
+
+        for (size_t i = 0; i < started; i++)
+                pthread_join(workers->threads[i], NULL);
+}
+
+static void ent_workers_destroy(struct ent_workers *workers)
+{
+        pthread_cond_destroy(&workers->done_cond);
+        pthread_cond_destroy(&workers->start_cond);
+        pthread_mutex_destroy(&workers->mutex);
+        free(workers->threads);
+        free(workers);
+}
+
+struct ent_workers* ent_workers_create(size_t count)
+{
+        if (count == 0)
+                return NULL;
+
+        struct ent_workers *workers = calloc(1, sizeof(struct ent_workers));
+        if (workers == NULL)
+                return NULL;
+
+        workers->threads = calloc(count, sizeof(pthread_t));
+        if (workers->threads == NULL) {
+                free(workers);
+                return NULL;
+        }
+
+        workers->count = count;
+        atomic_init(&workers->next_task, 0);
+        pthread_mutex_init(&workers->mutex, NULL);
+        pthread_cond_init(&workers->start_cond, NULL);
+        pthread_cond_init(&workers->done_cond, NULL);
+
+        for (size_t i = 0; i < count; i++) {
+                if (pthread_create(&workers->threads[i], NULL, ent_workers_thread, workers) != 0) {
+                        ent_workers_stop(workers, i);
+                        ent_workers_destroy(workers);
+                        return NULL;
+                }
+        }
+
+        return workers;
+}
+
+void ent_workers_free(struct ent_workers **workers)
+{
+        if (workers != NULL && *workers != NULL) {
+                ent_workers_stop(*workers, (*workers)->count);
+                ent_workers_destroy(*workers);
+                *workers = NULL;
+        }
+}
+
+size_t ent_workers_count(const struct ent_workers *workers)
+{
+        return workers->count;
+}
+
+void ent_workers_run(struct ent_workers *workers,
+                     ent_workers_task task,
+                     void *data,
+                     size_t num_tasks)
+{
+        pthread_mutex_lock(&workers->mutex);
+        workers->task = task;
+        workers->data = data;
+        workers->num_tasks = num_tasks;
+        workers->finished = 0;
+        atomic_store_explicit(&workers->next_task, 0, memory_order_relaxed);
+        workers->batch++;
+        pthread_cond_broadcast(&workers->start_cond);
+        pthread_mutex_unlock(&workers->mutex);
+
+        ent_workers_claim_tasks(workers, task, data, num_tasks);
+
+        pthread_mutex_lock(&workers->mutex);
+        while (workers->finished < workers->count)
+                pthread_cond_wait(&workers->done_cond, &workers->mutex);
+        pthread_mutex_unlock(&workers->mutex);
+}
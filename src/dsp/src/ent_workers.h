@@ -0,0 +1,70 @@
+/**
+ * File name: ent_workers.h
+ * Project: Entropictron (A texture synthesizer)
+ *
+ * Copyright (C) 2025 Iurie Nistor
+ *
+ * This file is part of Entropictron.
+ *
+ * Entropictron is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef ENT_WORKERS_H
+#define ENT_WORKERS_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Pool of worker threads running the tasks of a batch in parallel.
+ *
+ * The tasks are claimed with an atomic counter shared by the workers
+ * and the calling thread, a thread that finishes its task takes the
+ * next unclaimed one. The threads sleep between batches, so the pool
+ * is meant for offline processing, not for the realtime audio thread.
+ */
+struct ent_workers;
+
+/**
+ * Runs the task with the given index.
+ */
+typedef void (*ent_workers_task)(void *data, size_t index);
+
+/**
+ * Creates a pool of count threads. Returns NULL if count is zero
+ * or the threads can't be created.
+ */
+struct ent_workers* ent_workers_create(size_t count);
+
+void ent_workers_free(struct ent_workers **workers);
+
+size_t ent_workers_count(const struct ent_workers *workers);
+
+/**
+ * Runs the tasks [0, num_tasks) on the workers and the calling
+ * thread, returns when all of them are done.
+ */
+void ent_workers_run(struct ent_workers *workers,
+                     ent_workers_task task,
+                     void *data,
+                     size_t num_tasks);
+
+#ifdef __cplusplus
+}
+#endif
+#endif // ENT_WORKERS_H
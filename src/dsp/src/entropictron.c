@@ -25,48 +25,377 @@
 #include "ent_noise.h"
 #include "ent_crackle.h"
 #include "ent_glitch.h"
+#include "ent_history.h"
 #include "ent_rgate.h"
 #include "ent_log.h"
+#include "ent_memory.h"
 #include "ent_state_internal.h"
+#include "ent_workers.h"
 
 #include "qx_math.h"
 #include "qx_randomizer.h"
 #include "qx_smoother.h"
 
-struct entropictron {
-        // Parameters
-        enum ent_play_mode play_mode;
-        float entropy_rate;
-        float entropy_depth;
+#include <math.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <string.h>
 
-	unsigned int sample_rate;
+// A ramp for each parameter of each noise.
+#define ENT_NUM_RAMPS (ENT_NOISE_BANK_SIZE * ENT_NUM_PARAMS)
+
+/**
+ * The ramp of a parameter over the events of an ent_process_events()
+ * call. The parameter moves linearly from its value to the value of
+ * the target event.
+ */
+struct ent_ramp {
+        float value;
+        // Index of the target event, the events count if none.
+        size_t event;
+};
+
+/**
+ * Modules rendered by the worker threads, each into its own buffers.
+ * The outputs are added in this order, the order of the serial
+ * processing. The rgate modulates the input and runs on the calling
+ * thread after the sum.
+ */
+enum ent_task {
+        ENT_TASK_NOISE,
+        ENT_TASK_CRACKLE_1,
+        ENT_TASK_CRACKLE_2,
+        ENT_TASK_GLITCH_1,
+        ENT_TASK_GLITCH_2,
+        ENT_NUM_TASKS
+};
+
+// Stereo output buffers of the tasks and scratch buffers of the crackles.
+#define ENT_TASK_BUFFERS (2 * ENT_NUM_TASKS + 2 * 2)
+
+/**
+ * A chunk rendered by the worker threads.
+ */
+struct ent_parallel_block {
+        struct entropictron *ent;
+        struct ent_history *history;
+        float **in;
+        size_t size;
+        enum ent_task tasks[ENT_NUM_TASKS];
+};
+
+/**
+ * Resources for a new sample rate and maximum block size. They are
+ * allocated off the audio thread and swapped in by the audio thread,
+ * the config then holds the old resources until it is freed.
+ */
+struct ent_config {
+        unsigned int sample_rate;
+        size_t max_block_size;
+        struct ent_history *history;
+        struct ent_config *next;
+};
+
+/**
+ * The instance, its modules and the scratch memory are placed in
+ * a single cache line aligned block, in the processing order.
+ * The fields used by ent_process() come first, the rest is kept
+ * in the cold part at the end of the struct.
+ */
+struct entropictron {
+        // Hot data
         bool is_playing;
-        struct qx_smoother entropy;
-        float entropy_abs;
-        struct ent_noise* noise[2];
+	unsigned int sample_rate;
+        size_t max_block_size;
+        _Atomic(struct ent_config*) pending_config;
+        struct ent_noise* noise[ENT_NOISE_BANK_SIZE];
         struct ent_crackle *crackle[2];
         struct ent_glitch *glitch[2];
+        // Input history shared by the glitch modules.
+        _Atomic(struct ent_history*) glitch_history;
         struct ent_rgate *rgate;
+        // Entropy modulation of the noises, evaluated at the control points.
+        float entropy_rate;
+        float entropy_depth;
+        float entropy_control_rate;
+        size_t entropy_frames_left;
+        // Frames between the control points.
+        size_t entropy_control_frames;
+        // Control points left before the next random walk step.
+        size_t entropy_steps_left;
+        struct qx_smoother entropy;
+        // The value passed to the noises at the last control point.
+        float entropy_value;
         struct qx_randomizer prob_randomizer;
         struct qx_randomizer entropy_randomizer;
+        // Parameter ramps of the ent_process_events() call, advanced
+        // to the frame of the call rendered next by the noises.
+        const struct ent_event *events;
+        size_t events_count;
+        struct ent_ramp ramps[ENT_NUM_RAMPS];
+        size_t ramps_frame;
+        // A ramp has events left.
+        bool ramps_active;
+        // Scratch memory shared by the generators.
+        size_t scratch_frames;
+        float *scratch[2];
+        // Parallel rendering in offline mode.
+        bool offline;
+        size_t parallel_threshold;
+        struct ent_workers *workers;
+        float *task_out[ENT_NUM_TASKS][2];
+        float *task_scratch[2][2];
+
+        // Cold data
+        enum ent_play_mode play_mode;
+        float entropy_abs;
+
+        // The configuration requested by ent_prepare().
+        unsigned int config_sample_rate;
+        size_t config_max_block_size;
+        _Atomic(struct ent_config*) retired_configs;
+
+        // The DSP memory of the instance.
+        size_t arena_size;
+        struct ent_memory_region arena_memory;
+        struct ent_memory_region task_memory;
+        // The regions of the arena, the task buffers and the histories.
+        struct ent_memory_region *memory_regions;
+        atomic_size_t memory_size;
+        bool lock_memory;
+        atomic_bool memory_locked;
 };
 
+/**
+ * Adds the region to the memory of the instance. The region
+ * is kept in the block it describes.
+ */
+static void
+ent_add_memory_region(struct entropictron *ent, struct ent_memory_region *region)
+{
+        region->next = ent->memory_regions;
+        ent->memory_regions = region;
+        atomic_fetch_add(&ent->memory_size, region->size);
+
+        if (ent->lock_memory && !ent_memory_lock(region->ptr, region->size))
+                atomic_store(&ent->memory_locked, false);
+}
+
+static void
+ent_remove_memory_region(struct entropictron *ent, struct ent_memory_region *region)
+{
+        for (struct ent_memory_region **r = &ent->memory_regions; *r != NULL; r = &(*r)->next) {
+                if (*r != region)
+                        continue;
+
+                if (ent->lock_memory)
+                        ent_memory_unlock(region->ptr, region->size);
+                atomic_fetch_sub(&ent->memory_size, region->size);
+                *r = region->next;
+                return;
+        }
+}
+
+static void
+ent_add_history_memory(struct entropictron *ent, struct ent_history *history)
+{
+        for (size_t i = 0; i < QX_ARRAY_SIZE(history->memory); i++)
+                ent_add_memory_region(ent, &history->memory[i]);
+}
+
+static void
+ent_remove_history_memory(struct entropictron *ent, struct ent_history *history)
+{
+        for (size_t i = 0; i < QX_ARRAY_SIZE(history->memory); i++)
+                ent_remove_memory_region(ent, &history->memory[i]);
+}
+
+static struct ent_history*
+ent_create_glitch_history(struct entropictron *ent, unsigned int sample_rate)
+{
+        struct ent_history *history = ent_history_create(sample_rate,
+                                                         ENT_GLITCH_HISTORY_LENGTH,
+                                                         ENT_MAX_SCRATCH_FRAMES
+                                                         + ENT_GLITCH_HISTORY_TAPS);
+        if (history == NULL) {
+                ent_log_error("can't allocate glitch history");
+                return NULL;
+        }
+
+        ent_add_history_memory(ent, history);
+        return history;
+}
+
+static void
+ent_free_glitch_history(struct entropictron *ent, struct ent_history **history)
+{
+        if (*history != NULL) {
+                ent_remove_history_memory(ent, *history);
+                ent_history_free(history);
+        }
+}
+
+static void
+ent_config_free(struct entropictron *ent, struct ent_config **config)
+{
+        if (*config != NULL) {
+                ent_free_glitch_history(ent, &(*config)->history);
+                free(*config);
+                *config = NULL;
+        }
+}
+
+static struct ent_config*
+ent_config_create(struct entropictron *ent,
+                  unsigned int sample_rate,
+                  size_t max_block_size,
+                  bool with_history)
+{
+        struct ent_config *config = calloc(1, sizeof(struct ent_config));
+        if (config == NULL)
+                return NULL;
+
+        config->sample_rate = sample_rate;
+        config->max_block_size = max_block_size;
+
+        if (with_history) {
+                config->history = ent_create_glitch_history(ent, sample_rate);
+                if (config->history == NULL) {
+                        ent_config_free(ent, &config);
+                        return NULL;
+                }
+        }
+
+        return config;
+}
+
+/**
+ * Returns the number of frames processed at once for the given
+ * maximum block size.
+ */
+static size_t ent_scratch_frames(size_t max_block_size)
+{
+        // Keep the chunks aligned to the cache line.
+        const size_t align = ENT_CACHE_LINE_SIZE / sizeof(float);
+        size_t frames = QX_CLAMP(max_block_size, align, ENT_MAX_SCRATCH_FRAMES);
+        return (frames + align - 1) / align * align;
+}
+
+/**
+ * Swaps the config history with the current one and updates the
+ * modules. Doesn't allocate, is called from the audio thread.
+ */
+static void
+ent_apply_config(struct entropictron *ent, struct ent_config *config)
+{
+        ent->scratch_frames = ent_scratch_frames(config->max_block_size);
+
+        if (config->history != NULL)
+                config->history = atomic_exchange(&ent->glitch_history, config->history);
+
+        ent->max_block_size = config->max_block_size;
+        if (config->sample_rate == ent->sample_rate)
+                return;
+
+        ent->sample_rate = config->sample_rate;
+        for (size_t i = 0; i < QX_ARRAY_SIZE(ent->noise); i++)
+                ent_noise_set_sample_rate(ent->noise[i], ent->sample_rate);
+        for (size_t i = 0; i < QX_ARRAY_SIZE(ent->crackle); i++)
+                ent_crackle_set_sample_rate(ent->crackle[i], ent->sample_rate);
+        for (size_t i = 0; i < QX_ARRAY_SIZE(ent->glitch); i++)
+                ent_glitch_set_sample_rate(ent->glitch[i], ent->sample_rate);
+        ent_rgate_set_sample_rate(ent->rgate, ent->sample_rate);
+}
+
+/**
+ * Applies the pending config, if any. Called from the audio thread.
+ */
+static void
+ent_commit_config(struct entropictron *ent)
+{
+        if (atomic_load_explicit(&ent->pending_config, memory_order_relaxed) == NULL)
+                return;
+
+        struct ent_config *config = atomic_exchange_explicit(&ent->pending_config,
+                                                             NULL,
+                                                             memory_order_acquire);
+        if (config == NULL)
+                return;
+
+        ent_apply_config(ent, config);
+
+        // Pass the old resources to be freed off the audio thread.
+        struct ent_config *next = atomic_load_explicit(&ent->retired_configs,
+                                                       memory_order_relaxed);
+        do {
+                config->next = next;
+        } while (!atomic_compare_exchange_weak_explicit(&ent->retired_configs,
+                                                        &next,
+                                                        config,
+                                                        memory_order_release,
+                                                        memory_order_relaxed));
+}
+
+static void
+ent_free_retired_configs(struct entropictron *ent)
+{
+        struct ent_config *config = atomic_exchange_explicit(&ent->retired_configs,
+                                                             NULL,
+                                                             memory_order_acquire);
+        while (config != NULL) {
+                struct ent_config *next = config->next;
+                ent_config_free(ent, &config);
+                config = next;
+        }
+}
+
+/**
+ * Returns the size of the block holding the instance, the modules
+ * and the scratch memory.
+ */
+static size_t ent_arena_size(void)
+{
+        const struct entropictron *ent = NULL;
+        return ENT_ARENA_SIZE(sizeof(*ent))
+                + QX_ARRAY_SIZE(ent->noise) * ENT_ARENA_SIZE(ent_noise_size())
+                + QX_ARRAY_SIZE(ent->crackle) * ENT_ARENA_SIZE(ent_crackle_size())
+                + QX_ARRAY_SIZE(ent->glitch) * ENT_ARENA_SIZE(ent_glitch_size())
+                + ENT_ARENA_SIZE(ent_rgate_size())
+                + QX_ARRAY_SIZE(ent->scratch) * ENT_ARENA_SIZE(ENT_MAX_SCRATCH_FRAMES * sizeof(float));
+}
+
 enum ent_error
 ent_create(struct entropictron **ent, unsigned int sample_rate)
 {
 	if (ent == NULL)
 		return ENT_ERROR;
 
-	*ent = calloc(1, sizeof(struct entropictron));
-	if (*ent == NULL)
+        size_t arena_size = ent_arena_size();
+        void *mem = ent_aligned_alloc(arena_size);
+	if (mem == NULL)
 		return ENT_ERROR_MEM_ALLOC;
 
+        // The arena is sized for all the allocations below.
+        struct ent_arena arena;
+        ent_arena_init(&arena, mem, arena_size);
+        *ent = ent_arena_alloc(&arena, sizeof(struct entropictron));
+        (*ent)->arena_size = arena_size;
+        (*ent)->arena_memory.ptr = mem;
+        (*ent)->arena_memory.size = arena_size;
+        ent_add_memory_region(*ent, &(*ent)->arena_memory);
+
 	(*ent)->sample_rate = sample_rate;
+        (*ent)->config_sample_rate = sample_rate;
+        (*ent)->max_block_size = ENT_DEFAULT_MAX_BLOCK_SIZE;
+        (*ent)->config_max_block_size = ENT_DEFAULT_MAX_BLOCK_SIZE;
+        (*ent)->scratch_frames = ent_scratch_frames(ENT_DEFAULT_MAX_BLOCK_SIZE);
         (*ent)->is_playing = false;
+        (*ent)->parallel_threshold = ENT_DEFAULT_PARALLEL_THRESHOLD;
         (*ent)->play_mode = ENT_PLAY_MODE_PLAYBACK;
         (*ent)->entropy_rate = ENT_DEFAULT_ENTROPY_RATE;
         (*ent)->entropy_depth = ENT_DEFAULT_ENTROPY_DEPTH;
-        qx_smoother_init(&(*ent)->entropy, 0.0f, 2.0f);
+        (*ent)->entropy_control_rate = ENT_DEFAULT_ENTROPY_CONTROL_RATE;
+        qx_smoother_init(&(*ent)->entropy, 0.0f, 1);
 
         qx_randomizer_init(&(*ent)->prob_randomizer,
                            0.0f, 1.0f,
@@ -75,46 +404,26 @@ ent_create(struct entropictron **ent, unsigned int sample_rate)
                            -1.0f, 1.0f,
                            1.0f / 65536.0f);
 
-        // Create noise
+        // Place the modules in the processing order.
         size_t num_noises = QX_ARRAY_SIZE((*ent)->noise);
-        for (size_t i = 0; i < num_noises; i++) {
-                (*ent)->noise[i] = ent_noise_create(sample_rate);
-                if ((*ent)->noise[i] == NULL) {
-                        ent_log_error("can't create noise");
-                        ent_free(ent);
-                        return ENT_ERROR;
-                }
-        }
+        for (size_t i = 0; i < num_noises; i++)
+                (*ent)->noise[i] = ent_noise_init(ent_arena_alloc(&arena, ent_noise_size()),
+                                                  sample_rate);
 
-        // Create crackle
         size_t num_crackles = QX_ARRAY_SIZE((*ent)->crackle);
-        for (size_t i = 0; i < num_crackles; i++) {
-                (*ent)->crackle[i] = ent_crackle_create(sample_rate);
-                if ((*ent)->crackle[i] == NULL) {
-                        ent_log_error("can't create crackle");
-                        ent_free(ent);
-                        return ENT_ERROR;
-                }
-        }
+        for (size_t i = 0; i < num_crackles; i++)
+                (*ent)->crackle[i] = ent_crackle_init(ent_arena_alloc(&arena, ent_crackle_size()),
+                                                      sample_rate);
 
-        // Create glitch
         size_t num_glitchs = QX_ARRAY_SIZE((*ent)->glitch);
-        for (size_t i = 0; i < num_glitchs; i++) {
-                (*ent)->glitch[i] = ent_glitch_create(sample_rate);
-                if ((*ent)->glitch[i] == NULL) {
-                        ent_log_error("can't create glitch module");
-                        ent_free(ent);
-                        return ENT_ERROR;
-                }
-        }
+        for (size_t i = 0; i < num_glitchs; i++)
+                (*ent)->glitch[i] = ent_glitch_init(ent_arena_alloc(&arena, ent_glitch_size()),
+                                                    sample_rate);
 
-        // Create rgate
-        (*ent)->rgate = ent_rgate_create(sample_rate);
-        if ((*ent)->rgate == NULL) {
-                ent_log_error("can't create rgate module");
-                ent_free(ent);
-                return ENT_ERROR;
-        }
+        (*ent)->rgate = ent_rgate_init(ent_arena_alloc(&arena, ent_rgate_size()), sample_rate);
+
+        for (size_t ch = 0; ch < QX_ARRAY_SIZE((*ent)->scratch); ch++)
+                (*ent)->scratch[ch] = ent_arena_alloc(&arena, ENT_MAX_SCRATCH_FRAMES * sizeof(float));
 
 	return ENT_OK;
 }
@@ -122,29 +431,68 @@ ent_create(struct entropictron **ent, unsigned int sample_rate)
 void ent_free(struct entropictron **ent)
 {
         if (ent != NULL && *ent != NULL) {
-                // Free noise
-                size_t num_noises = QX_ARRAY_SIZE((*ent)->noise);
-                for (size_t i = 0; i < num_noises; i++)
-                        ent_noise_free(&(*ent)->noise[i]);
+                ent_set_worker_threads(*ent, 0);
+                ent_set_memory_lock(*ent, false);
 
-                // Free crackle
-                size_t num_crackles = QX_ARRAY_SIZE((*ent)->crackle);
-                for (size_t i = 0; i < num_crackles; i++)
-                        ent_crackle_free(&(*ent)->crackle[i]);
+                struct ent_config *config = atomic_load(&(*ent)->pending_config);
+                ent_config_free(*ent, &config);
+                ent_free_retired_configs(*ent);
 
-                // Free glitch
-                size_t num_glitchs = QX_ARRAY_SIZE((*ent)->glitch);
-                for (size_t i = 0; i < num_glitchs; i++)
-                        ent_glitch_free(&(*ent)->glitch[i]);
+                struct ent_history *history = atomic_load(&(*ent)->glitch_history);
+                ent_history_free(&history);
 
-                // Free rgate
-                ent_rgate_free(&(*ent)->rgate);
+                // The task buffers are allocated as a single block.
+                if ((*ent)->task_out[0][0] != NULL)
+                        ent_aligned_free((*ent)->task_out[0][0]);
 
-                free(*ent);
+                // The instance is at the start of the arena.
+                ent_aligned_free(*ent);
                 *ent = NULL;
         }
 }
 
+enum ent_error
+ent_prepare(struct entropictron *ent, unsigned int sample_rate, size_t max_block_size)
+{
+        if (ent == NULL || sample_rate < 1 || max_block_size < 1) {
+                ent_log_error("wrong arguments");
+                return ENT_ERROR_WRONG_ARGUMENTS;
+        }
+
+        ent_free_retired_configs(ent);
+
+        // The history is rebuilt only if it is already allocated at another rate.
+        struct ent_history *history = atomic_load_explicit(&ent->glitch_history,
+                                                           memory_order_acquire);
+        bool with_history = history != NULL
+                && history->sample_rate != (int)sample_rate;
+        struct ent_config *config = ent_config_create(ent,
+                                                      sample_rate,
+                                                      max_block_size,
+                                                      with_history);
+        if (config == NULL) {
+                ent_log_error("can't prepare for sample rate %u, block size %zu",
+                              sample_rate, max_block_size);
+                return ENT_ERROR_MEM_ALLOC;
+        }
+
+        ent->config_sample_rate = sample_rate;
+        ent->config_max_block_size = max_block_size;
+
+        // The shared designs are looked up by the modules when the
+        // audio thread applies the rate.
+        ent_noise_prepare(sample_rate);
+        ent_crackle_prepare(sample_rate);
+
+        // Replace the config not yet taken by the audio thread.
+        struct ent_config *old = atomic_exchange_explicit(&ent->pending_config,
+                                                          config,
+                                                          memory_order_acq_rel);
+        ent_config_free(ent, &old);
+
+        return ENT_OK;
+}
+
 enum ent_error
 ent_set_sample_rate(struct entropictron *ent, unsigned int rate)
 {
@@ -153,8 +501,7 @@ ent_set_sample_rate(struct entropictron *ent, unsigned int rate)
                 return ENT_ERROR;
         }
 
-        ent->sample_rate = rate;
-        return ENT_OK;
+        return ent_prepare(ent, rate, ent->config_max_block_size);
 }
 
 enum ent_error
@@ -165,10 +512,208 @@ ent_get_sample_rate(const struct entropictron *ent, unsigned int *sample_rate)
                 return ENT_ERROR;
         }
 
-        *sample_rate = ent->sample_rate;
+        *sample_rate = ent->config_sample_rate;
+        return ENT_OK;
+}
+
+enum ent_error
+ent_set_max_block_size(struct entropictron *ent, size_t size)
+{
+        if (ent == NULL || size < 1) {
+                ent_log_error("wrong arguments");
+                return ENT_ERROR_WRONG_ARGUMENTS;
+        }
+
+        return ent_prepare(ent, ent->config_sample_rate, size);
+}
+
+size_t ent_get_max_block_size(const struct entropictron *ent)
+{
+        return ent->config_max_block_size;
+}
+
+enum ent_error ent_alloc_glitch_history(struct entropictron *ent)
+{
+        if (atomic_load_explicit(&ent->glitch_history, memory_order_acquire) != NULL)
+                return ENT_OK;
+
+        struct ent_history *history = ent_create_glitch_history(ent, ent->config_sample_rate);
+        if (history == NULL)
+                return ENT_ERROR_MEM_ALLOC;
+
+        // Publish the history to the audio thread, it is replaced
+        // only by a config for a new sample rate.
+        struct ent_history *expected = NULL;
+        if (!atomic_compare_exchange_strong_explicit(&ent->glitch_history,
+                                                     &expected,
+                                                     history,
+                                                     memory_order_release,
+                                                     memory_order_relaxed))
+                ent_free_glitch_history(ent, &history);
+
+        return ENT_OK;
+}
+
+enum ent_error ent_set_memory_lock(struct entropictron *ent, bool lock)
+{
+        if (ent == NULL) {
+                ent_log_error("wrong arguments");
+                return ENT_ERROR_WRONG_ARGUMENTS;
+        }
+
+        bool locked = true;
+        for (struct ent_memory_region *region = ent->memory_regions;
+             region != NULL;
+             region = region->next) {
+                if (lock)
+                        locked = ent_memory_lock(region->ptr, region->size) && locked;
+                else if (ent->lock_memory)
+                        ent_memory_unlock(region->ptr, region->size);
+        }
+
+        ent->lock_memory = lock;
+        atomic_store(&ent->memory_locked, lock && locked);
+        if (lock && !locked) {
+                ent_log_error("can't lock DSP memory");
+                return ENT_ERROR;
+        }
+
+        return ENT_OK;
+}
+
+bool ent_is_memory_locked(const struct entropictron *ent)
+{
+        return atomic_load(&ent->memory_locked);
+}
+
+void ent_prefault_memory(struct entropictron *ent)
+{
+        for (struct ent_memory_region *region = ent->memory_regions;
+             region != NULL;
+             region = region->next)
+                ent_memory_prefault(region->ptr, region->size);
+}
+
+size_t ent_get_memory_size(const struct entropictron *ent)
+{
+        return atomic_load(&ent->memory_size);
+}
+
+enum ent_error ent_set_worker_threads(struct entropictron *ent, size_t count)
+{
+        if (ent == NULL) {
+                ent_log_error("wrong arguments");
+                return ENT_ERROR_WRONG_ARGUMENTS;
+        }
+
+        count = QX_MIN(count, ENT_MAX_WORKER_THREADS);
+        if (ent->workers != NULL && ent_workers_count(ent->workers) == count)
+                return ENT_OK;
+
+        ent_workers_free(&ent->workers);
+        if (count == 0)
+                return ENT_OK;
+
+        // The buffers are kept after the first allocation.
+        if (ent->task_out[0][0] == NULL) {
+                size_t size = ENT_TASK_BUFFERS * ENT_MAX_SCRATCH_FRAMES * sizeof(float);
+                float *mem = ent_aligned_alloc(size);
+                if (mem == NULL) {
+                        ent_log_error("can't allocate task buffers");
+                        return ENT_ERROR_MEM_ALLOC;
+                }
+                ent->task_memory.ptr = mem;
+                ent->task_memory.size = size;
+                ent_add_memory_region(ent, &ent->task_memory);
+
+                for (size_t i = 0; i < ENT_NUM_TASKS; i++) {
+                        for (size_t ch = 0; ch < 2; ch++, mem += ENT_MAX_SCRATCH_FRAMES)
+                                ent->task_out[i][ch] = mem;
+                }
+                for (size_t i = 0; i < QX_ARRAY_SIZE(ent->task_scratch); i++) {
+                        for (size_t ch = 0; ch < 2; ch++, mem += ENT_MAX_SCRATCH_FRAMES)
+                                ent->task_scratch[i][ch] = mem;
+                }
+        }
+
+        ent->workers = ent_workers_create(count);
+        if (ent->workers == NULL) {
+                ent_log_error("can't create %zu worker threads", count);
+                return ENT_ERROR;
+        }
+
         return ENT_OK;
 }
 
+size_t ent_get_worker_threads(const struct entropictron *ent)
+{
+        return ent->workers != NULL ? ent_workers_count(ent->workers) : 0;
+}
+
+void ent_set_parallel_threshold(struct entropictron *ent, size_t frames)
+{
+        ent->parallel_threshold = frames;
+}
+
+size_t ent_get_parallel_threshold(const struct entropictron *ent)
+{
+        return ent->parallel_threshold;
+}
+
+void ent_set_offline(struct entropictron *ent, bool offline)
+{
+        ent->offline = offline;
+}
+
+bool ent_is_offline(const struct entropictron *ent)
+{
+        return ent->offline;
+}
+
+size_t ent_get_memory_layout(const struct entropictron *ent,
+                             struct ent_memory_layout_entry *entries,
+                             size_t max_entries)
+{
+        const char *base = (const char*)ent;
+        const size_t cold_offset = offsetof(struct entropictron, play_mode);
+        const struct ent_memory_layout_entry layout[] = {
+                {"entropictron hot", 0, cold_offset},
+                {"entropictron cold", cold_offset, sizeof(*ent) - cold_offset},
+                {"noise[0]", (const char*)ent->noise[0] - base, ent_noise_size()},
+                {"noise[1]", (const char*)ent->noise[1] - base, ent_noise_size()},
+                {"crackle[0]", (const char*)ent->crackle[0] - base, ent_crackle_size()},
+                {"crackle[1]", (const char*)ent->crackle[1] - base, ent_crackle_size()},
+                {"glitch[0]", (const char*)ent->glitch[0] - base, ent_glitch_size()},
+                {"glitch[1]", (const char*)ent->glitch[1] - base, ent_glitch_size()},
+                {"rgate", (const char*)ent->rgate - base, ent_rgate_size()},
+                {"scratch[0]", (const char*)ent->scratch[0] - base,
+                 ENT_MAX_SCRATCH_FRAMES * sizeof(float)},
+                {"scratch[1]", (const char*)ent->scratch[1] - base,
+                 ENT_MAX_SCRATCH_FRAMES * sizeof(float)}
+        };
+
+        size_t n = QX_ARRAY_SIZE(layout);
+        if (n > max_entries)
+                n = max_entries;
+        for (size_t i = 0; i < n; i++)
+                entries[i] = layout[i];
+        return n;
+}
+
+bool ent_is_glitch_history_needed(const struct entropictron *ent)
+{
+        if (atomic_load_explicit(&ent->glitch_history, memory_order_acquire) != NULL)
+                return false;
+
+        size_t n = QX_ARRAY_SIZE(ent->glitch);
+        for (size_t i = 0; i < n; i++) {
+                if (ent_glitch_is_enabled(ent->glitch[i]))
+                        return true;
+        }
+
+        return false;
+}
+
 enum ent_error ent_set_play_mode(struct entropictron *ent, enum ent_play_mode mode)
 {
         ent->play_mode = mode;
@@ -213,14 +758,30 @@ float ent_get_entropy(struct entropictron *ent)
         return qx_smoother_get(&ent->entropy);
 }
 
-void ent_update_entropy(struct entropictron *ent)
+void ent_set_entropy_control_rate(struct entropictron *ent, float rate)
+{
+        ent->entropy_control_rate = qx_clamp_float(rate,
+                                                   ENT_ENTROPY_CONTROL_RATE_MIN,
+                                                   ENT_ENTROPY_CONTROL_RATE_MAX);
+}
+
+float ent_get_entropy_control_rate(const struct entropictron *ent)
+{
+        return ent->entropy_control_rate;
+}
+
+/**
+ * Takes a step of the entropy random walk, with the probability
+ * given by the entropy rate.
+ */
+static void ent_entropy_step(struct entropictron *ent)
 {
         float step = 0.0f;
         float prob = qx_randomizer_get_float(&ent->prob_randomizer);
         if (prob >= ENT_ENTROPY_RATE_MIN && prob <= ent->entropy_rate)
                 step = qx_randomizer_get_float(&ent->entropy_randomizer);
 
-        float target = qx_smoother_next(&ent->entropy) + step;
+        float target = qx_smoother_get(&ent->entropy) + step;
 
         // Do reflection if needed.
         if (target > 1.0f)
@@ -230,46 +791,334 @@ void ent_update_entropy(struct entropictron *ent)
 
         target = qx_clamp_float(target, -1.0f, 1.0f);
         qx_smoother_set_target(&ent->entropy, target);
+}
+
+/**
+ * Advances the entropy to the next control point. Between the random
+ * walk steps the entropy moves linearly, the noises ramp to its value
+ * at the next control point.
+ */
+static void ent_entropy_control_point(struct entropictron *ent)
+{
+        const float rate = ent->entropy_control_rate;
+        const size_t frames = QX_MAX(lrintf((float)ent->sample_rate / rate), 1L);
+        ent->entropy_control_frames = frames;
+        ent->entropy_frames_left = frames;
+
+        if (ent->entropy_steps_left == 0) {
+                ent->entropy_steps_left = QX_MAX(lrintf(ENT_ENTROPY_STEP_PERIOD * rate), 1L);
+                qx_smoother_set_frames(&ent->entropy, ent->entropy_steps_left);
+                ent_entropy_step(ent);
+        }
+        ent->entropy_steps_left--;
 
         float entropy = qx_smoother_next(&ent->entropy) * ent->entropy_depth;
+
+        // While the entropy holds, the control points up to the next
+        // step are skipped and the noises are rendered in longer blocks.
+        if (entropy == ent->entropy_value) {
+                ent->entropy_frames_left = frames * (ent->entropy_steps_left + 1);
+                ent->entropy_steps_left = 0;
+                return;
+        }
+
+        ent->entropy_value = entropy;
         size_t n = QX_ARRAY_SIZE(ent->noise);
         for (size_t i = 0; i < n; i++)
-                ent_noise_set_entropy(ent->noise[i], entropy);
+                ent_noise_set_entropy(ent->noise[i], entropy, frames);
 }
 
-enum ent_error
-ent_process(struct entropictron *ent, float** data, size_t size)
+static void ent_set_param(struct entropictron *ent, size_t ramp, float value)
 {
-        if (!ent->is_playing)
-                return ENT_OK;
+        struct ent_noise *noise = ent->noise[ramp / ENT_NUM_PARAMS];
+        switch (ramp % ENT_NUM_PARAMS) {
+        case ENT_PARAM_NOISE_DENSITY:
+                ent_noise_set_density(noise, value);
+                break;
+        case ENT_PARAM_NOISE_GAIN:
+                ent_noise_set_gain(noise, value);
+                break;
+        case ENT_PARAM_NOISE_CUTOFF:
+                ent_noise_set_cutoff(noise, value);
+                break;
+        default: // resonance
+                ent_noise_set_resonance(noise, value);
+                break;
+        }
+}
 
-        float *in[2] = {data[0], data[1]};
-        float *out[2] = {data[2], data[3]};
+static float ent_get_param(const struct entropictron *ent, size_t ramp)
+{
+        const struct ent_noise *noise = ent->noise[ramp / ENT_NUM_PARAMS];
+        switch (ramp % ENT_NUM_PARAMS) {
+        case ENT_PARAM_NOISE_DENSITY:
+                return ent_noise_get_density(noise);
+        case ENT_PARAM_NOISE_GAIN:
+                return ent_noise_get_gain(noise);
+        case ENT_PARAM_NOISE_CUTOFF:
+                return ent_noise_get_cutoff(noise);
+        default: // resonance
+                return ent_noise_get_resonance(noise);
+        }
+}
 
-        size_t n = QX_ARRAY_SIZE(ent->noise);
-        for (size_t i = 0; i < n; i++) {
-                struct ent_noise *noise = ent->noise[i];
-                if (ent_noise_is_enabled(noise))
-                        ent_noise_process(noise, out, size);
+/**
+ * Returns the index of the first event of the ramp starting from the
+ * given index, or the events count if there is none.
+ */
+static size_t ent_ramp_find_event(const struct entropictron *ent, size_t ramp, size_t index)
+{
+        const size_t module = ramp / ENT_NUM_PARAMS;
+        const size_t param = ramp % ENT_NUM_PARAMS;
+        for (; index < ent->events_count; index++) {
+                const struct ent_event *event = &ent->events[index];
+                if ((size_t)event->module == module && (size_t)event->param == param)
+                        break;
         }
+        return index;
+}
 
-        n = QX_ARRAY_SIZE(ent->crackle);
+/**
+ * Advances the ramps to the frame of the call and sets the parameters
+ * to their values at the frame. A ramp passing its target event
+ * continues to the next event of its parameter.
+ */
+static void ent_advance_ramps(struct entropictron *ent, size_t frame)
+{
+        ent->ramps_active = false;
+        for (size_t i = 0; i < ENT_NUM_RAMPS; i++) {
+                struct ent_ramp *ramp = &ent->ramps[i];
+                if (ramp->event == ent->events_count)
+                        continue;
+
+                size_t start = ent->ramps_frame;
+                const struct ent_event *event = &ent->events[ramp->event];
+                while (event->offset <= frame) {
+                        ramp->value = event->value;
+                        start = event->offset;
+                        ramp->event = ent_ramp_find_event(ent, i, ramp->event + 1);
+                        if (ramp->event == ent->events_count)
+                                break;
+                        event = &ent->events[ramp->event];
+                }
+
+                if (ramp->event < ent->events_count) {
+                        float t = (float)(frame - start) / (float)(event->offset - start);
+                        ramp->value += (event->value - ramp->value) * t;
+                        ent->ramps_active = true;
+                }
+                ent_set_param(ent, i, ramp->value);
+        }
+        ent->ramps_frame = frame;
+}
+
+static void
+ent_begin_ramps(struct entropictron *ent, const struct ent_event *events, size_t count)
+{
+        ent->events = events;
+        ent->events_count = count;
+        ent->ramps_frame = 0;
+        ent->ramps_active = false;
+        if (count == 0)
+                return;
+
+        for (size_t i = 0; i < ENT_NUM_RAMPS; i++) {
+                ent->ramps[i].value = ent_get_param(ent, i);
+                ent->ramps[i].event = ent_ramp_find_event(ent, i, 0);
+        }
+
+        // The events at the block start are applied at once, the noises
+        // ramp to them over the first part, kept to a control period.
+        ent_advance_ramps(ent, 0);
+        ent->ramps_active = true;
+}
+
+static void ent_end_ramps(struct entropictron *ent, size_t size)
+{
+        if (ent->events_count > 0 && ent->ramps_frame < size)
+                ent_advance_ramps(ent, size);
+        ent->events = NULL;
+        ent->events_count = 0;
+}
+
+/**
+ * Adds the noises to out, the block is split at the entropy
+ * control points. The parameter ramps are evaluated at the control
+ * points too and the noises interpolate them per sample, the events
+ * closer than a control period are smoothed.
+ */
+static void
+ent_process_noises(struct entropictron *ent, float **out, size_t size)
+{
+        for (size_t offset = 0; offset < size;) {
+                if (ent->entropy_frames_left == 0)
+                        ent_entropy_control_point(ent);
+
+                size_t frames = QX_MIN(size - offset, ent->entropy_frames_left);
+                if (ent->ramps_active) {
+                        // The held entropy doesn't skip the control points.
+                        frames = QX_MIN(frames, ent->entropy_control_frames);
+                        ent_advance_ramps(ent, ent->ramps_frame + frames);
+                }
+
+                float *data[2] = {out[0] + offset, out[1] + offset};
+                ent_noise_process_bank(ent->noise, data, frames);
+                ent->entropy_frames_left -= frames;
+                offset += frames;
+        }
+}
+
+static void
+ent_process_block(struct entropictron *ent, float **in, float **out, size_t size)
+{
+        ent_process_noises(ent, out, size);
+
+        size_t n = QX_ARRAY_SIZE(ent->crackle);
         for (size_t i = 0; i < n; i++) {
                 struct ent_crackle *crackle = ent->crackle[i];
                 if (ent_crackle_is_enabled(crackle))
-                        ent_crackle_process(crackle, out, size);
+                        ent_crackle_process(crackle, out, ent->scratch, size);
         }
 
+        struct ent_history *history = atomic_load_explicit(&ent->glitch_history,
+                                                           memory_order_acquire);
+        if (history != NULL)
+                ent_history_write(history, in, size);
+
         n = QX_ARRAY_SIZE(ent->glitch);
         for (size_t i = 0; i < n; i++) {
                 struct ent_glitch *glitch = ent->glitch[i];
                 if (ent_glitch_is_enabled(glitch))
-                        ent_glitch_process(glitch, in, out, size);
+                        ent_glitch_process(glitch, history, in, out, size);
         }
 
         if (ent_rgate_is_enabled(ent->rgate))
                 ent_rgate_process(ent->rgate, in, out, size);
+}
+
+/**
+ * Renders a module of the parallel block into its task buffers.
+ */
+static void ent_process_task(void *data, size_t index)
+{
+        struct ent_parallel_block *block = data;
+        struct entropictron *ent = block->ent;
+        enum ent_task task = block->tasks[index];
+        float **out = ent->task_out[task];
+        size_t size = block->size;
+
+        memset(out[0], 0, size * sizeof(float));
+        memset(out[1], 0, size * sizeof(float));
+
+        switch (task) {
+        case ENT_TASK_NOISE:
+                ent_process_noises(ent, out, size);
+                break;
+        case ENT_TASK_CRACKLE_1:
+        case ENT_TASK_CRACKLE_2:
+        {
+                size_t i = task - ENT_TASK_CRACKLE_1;
+                ent_crackle_process(ent->crackle[i], out, ent->task_scratch[i], size);
+                break;
+        }
+        case ENT_TASK_GLITCH_1:
+        case ENT_TASK_GLITCH_2:
+        {
+                size_t i = task - ENT_TASK_GLITCH_1;
+                ent_glitch_process(ent->glitch[i], block->history, block->in, out, size);
+                break;
+        }
+        default:
+                break;
+        }
+}
+
+/**
+ * Same as ent_process_block(), the enabled generators are rendered
+ * by the worker threads and added to out in the serial order.
+ */
+static void
+ent_process_block_parallel(struct entropictron *ent, float **in, float **out, size_t size)
+{
+        struct ent_parallel_block block = {
+                .ent = ent,
+                .history = atomic_load_explicit(&ent->glitch_history, memory_order_acquire),
+                .in = in,
+                .size = size
+        };
+
+        // The history is written before the glitches read it.
+        if (block.history != NULL)
+                ent_history_write(block.history, in, size);
+
+        size_t num_tasks = 0;
+        if (ent_noise_is_enabled(ent->noise[0]) || ent_noise_is_enabled(ent->noise[1]))
+                block.tasks[num_tasks++] = ENT_TASK_NOISE;
+        else
+                ent_process_noises(ent, out, size); // only advances the entropy
+        for (size_t i = 0; i < QX_ARRAY_SIZE(ent->crackle); i++) {
+                if (ent_crackle_is_enabled(ent->crackle[i]))
+                        block.tasks[num_tasks++] = ENT_TASK_CRACKLE_1 + i;
+        }
+        for (size_t i = 0; i < QX_ARRAY_SIZE(ent->glitch); i++) {
+                if (ent_glitch_is_enabled(ent->glitch[i]))
+                        block.tasks[num_tasks++] = ENT_TASK_GLITCH_1 + i;
+        }
+
+        ent_workers_run(ent->workers, ent_process_task, &block, num_tasks);
+
+        for (size_t t = 0; t < num_tasks; t++) {
+                float **task_out = ent->task_out[block.tasks[t]];
+                for (size_t i = 0; i < size; i++) {
+                        out[0][i] += task_out[0][i];
+                        out[1][i] += task_out[1][i];
+                }
+        }
+
+        if (ent_rgate_is_enabled(ent->rgate))
+                ent_rgate_process(ent->rgate, in, out, size);
+}
+
+enum ent_error
+ent_process(struct entropictron *ent, float** data, size_t size)
+{
+        return ent_process_events(ent, data, size, NULL, 0);
+}
+
+enum ent_error
+ent_process_events(struct entropictron *ent,
+                   float** data,
+                   size_t size,
+                   const struct ent_event *events,
+                   size_t count)
+{
+        ent_commit_config(ent);
+        ent_begin_ramps(ent, events, count);
+
+        if (!ent->is_playing) {
+                ent_end_ramps(ent, size);
+                return ENT_OK;
+        }
+
+        // Only the large offline blocks pay off the thread synchronization.
+        bool parallel = ent->offline
+                && ent->workers != NULL
+                && size >= ent->parallel_threshold;
+
+        // Split the blocks larger than the scratch memory.
+        for (size_t offset = 0; offset < size; offset += ent->scratch_frames) {
+                size_t frames = size - offset;
+                if (frames > ent->scratch_frames)
+                        frames = ent->scratch_frames;
+                float *in[2] = {data[0] + offset, data[1] + offset};
+                float *out[2] = {data[2] + offset, data[3] + offset};
+                if (parallel)
+                        ent_process_block_parallel(ent, in, out, frames);
+                else
+                        ent_process_block(ent, in, out, frames);
+        }
 
+        ent_end_ramps(ent, size);
         return ENT_OK;
 }
 
@@ -57,15 +57,152 @@ struct ent_state;
 #define ENT_ENTROPY_DEPTH_MIN 0.0f
 #define ENT_ENTROPY_DEPTH_MAX 1.0f
 
+// Rate in Hz at which the entropy is evaluated and passed to the noises,
+// the noises interpolate it per sample between the control points.
+#define ENT_DEFAULT_ENTROPY_CONTROL_RATE 1000.0f
+#define ENT_ENTROPY_CONTROL_RATE_MIN 100.0f
+#define ENT_ENTROPY_CONTROL_RATE_MAX 4000.0f
+
+// Period in seconds of the entropy random walk steps.
+#define ENT_ENTROPY_STEP_PERIOD 0.05f
+
+// Default maximum number of frames per ent_process() call.
+#define ENT_DEFAULT_MAX_BLOCK_SIZE 1024
+
+// Larger host blocks are processed in chunks of at most this size.
+#define ENT_MAX_SCRATCH_FRAMES 1024
+
+// Default minimum ent_process() call size rendered by the worker
+// threads in offline mode.
+#define ENT_DEFAULT_PARALLEL_THRESHOLD 1024
+
+// The calling thread renders too, more threads than modules
+// rendered in parallel minus one would stay idle.
+#define ENT_MAX_WORKER_THREADS 4
+
 
 enum ent_error ent_create(struct entropictron **ent, unsigned int sample_rate);
 
 void ent_free(struct entropictron **ent);
 
+/**
+ * Prepares the instance for a new sample rate and maximum block size.
+ * The memory is allocated here, on the setup thread, and the audio
+ * thread swaps it in at the start of the next ent_process() call,
+ * where the modules are updated without allocating. The old memory
+ * is freed by the next ent_prepare() or by ent_free().
+ * Larger blocks are still accepted by ent_process() and are
+ * processed in chunks.
+ */
+enum ent_error ent_prepare(struct entropictron *ent,
+                           unsigned int sample_rate,
+                           size_t max_block_size);
+
+/**
+ * Same as ent_prepare() keeping the maximum block size.
+ */
 enum ent_error ent_set_sample_rate(struct entropictron *ent, unsigned int rate);
 
 enum ent_error ent_get_sample_rate(const struct entropictron *ent, unsigned int *sample_rate);
 
+/**
+ * Same as ent_prepare() keeping the sample rate.
+ */
+enum ent_error ent_set_max_block_size(struct entropictron *ent, size_t size);
+
+size_t ent_get_max_block_size(const struct entropictron *ent);
+
+/**
+ * Allocates the input history shared by the glitch modules if it
+ * was not allocated yet. The history is allocated only on demand
+ * and this function must not be called from the audio thread.
+ * Until the history is allocated the glitch modules output only
+ * the dry signal.
+ */
+enum ent_error ent_alloc_glitch_history(struct entropictron *ent);
+
+/**
+ * Returns true if a glitch module is enabled but the history
+ * is not allocated yet.
+ */
+bool ent_is_glitch_history_needed(const struct entropictron *ent);
+
+/**
+ * Locks in RAM the DSP memory of the instance, including the memory
+ * allocated later (e.g. the glitch history), or unlocks it.
+ * Must not be called from the audio thread.
+ * Returns ENT_ERROR if the memory can't be locked
+ * (e.g. RLIMIT_MEMLOCK is too low).
+ */
+enum ent_error ent_set_memory_lock(struct entropictron *ent, bool lock);
+
+/**
+ * Returns true if all the DSP memory of the instance is locked in RAM.
+ */
+bool ent_is_memory_locked(const struct entropictron *ent);
+
+/**
+ * Touches all the DSP memory of the instance so the audio thread
+ * doesn't take page faults on the first access. Should be called
+ * on activation, must not be called from the audio thread.
+ */
+void ent_prefault_memory(struct entropictron *ent);
+
+/**
+ * Returns the size in bytes of the DSP memory held by the instance.
+ */
+size_t ent_get_memory_size(const struct entropictron *ent);
+
+// Maximum number of entries of the memory layout.
+#define ENT_MEMORY_LAYOUT_MAX_ENTRIES 16
+
+/**
+ * A part of the memory block of an instance.
+ */
+struct ent_memory_layout_entry {
+        const char *name;
+        // Offset from the start of the block.
+        size_t offset;
+        size_t size;
+};
+
+/**
+ * Fills the layout of the instance memory block (the hot and cold
+ * data of the instance, the modules and the scratch memory) in
+ * memory order. The glitch history is allocated separately when
+ * needed and is not part of the block.
+ * Returns the number of entries.
+ */
+size_t ent_get_memory_layout(const struct entropictron *ent,
+                             struct ent_memory_layout_entry *entries,
+                             size_t max_entries);
+
+/**
+ * Sets the number of worker threads rendering the modules in parallel,
+ * 0 disables the parallel rendering. The count is limited to
+ * ENT_MAX_WORKER_THREADS. The threads and their buffers are created
+ * here, must not be called concurrently with ent_process().
+ */
+enum ent_error ent_set_worker_threads(struct entropictron *ent, size_t count);
+
+size_t ent_get_worker_threads(const struct entropictron *ent);
+
+/**
+ * Sets the minimum number of frames of an ent_process() call
+ * rendered by the worker threads.
+ */
+void ent_set_parallel_threshold(struct entropictron *ent, size_t frames);
+
+size_t ent_get_parallel_threshold(const struct entropictron *ent);
+
+/**
+ * The worker threads are used only in offline mode (e.g. a bounce),
+ * the realtime processing stays on the audio thread.
+ */
+void ent_set_offline(struct entropictron *ent, bool offline);
+
+bool ent_is_offline(const struct entropictron *ent);
+
 enum ent_error ent_set_play_mode(struct entropictron *ent, enum ent_play_mode mode);
 
 enum ent_play_mode ent_get_play_mode(const struct entropictron *ent);
@@ -78,12 +215,60 @@ void ent_set_entropy_depth(struct entropictron *ent, float depth);
 
 float ent_get_entropy_depth(const struct entropictron *ent);
 
-float ent_get_entropy(struct entropictron *ent);
+void ent_set_entropy_control_rate(struct entropictron *ent, float rate);
+
+float ent_get_entropy_control_rate(const struct entropictron *ent);
 
-void ent_update_entropy(struct entropictron *ent);
+/**
+ * Returns the entropy, a random walk in [-1, 1] advanced by
+ * ent_process() with a step every ENT_ENTROPY_STEP_PERIOD.
+ */
+float ent_get_entropy(struct entropictron *ent);
 
 enum ent_error ent_process(struct entropictron *ent, float** data, size_t size);
 
+/**
+ * Parameters of the noises ramped by ent_process_events().
+ */
+enum ent_param {
+        ENT_PARAM_NOISE_DENSITY,
+        ENT_PARAM_NOISE_GAIN,
+        ENT_PARAM_NOISE_CUTOFF,
+        ENT_PARAM_NOISE_RESONANCE,
+        ENT_NUM_PARAMS
+};
+
+/**
+ * A point of a parameter ramp: the parameter of the module (the noise
+ * id) reaches the value, in the units of its setter, at the frame
+ * offset of the block.
+ */
+struct ent_event {
+        size_t offset;
+        enum ent_param param;
+        int module;
+        float value;
+};
+
+/**
+ * Same as ent_process(), the parameters ramp linearly from their
+ * values at the block start to the events, which must be sorted by
+ * offset. The block is not split at the events. While a ramp has
+ * events left, the noises are rendered in parts of at most a control
+ * period, also when the entropy holds. The ramps are evaluated at the
+ * ends of the parts and interpolated per sample by the noise kernels.
+ * The events closer than a control period, and the events at the block
+ * start, are thereby smoothed over at most a control period. An event
+ * with an offset past the block only ramps the parameter towards it
+ * and must be passed again, with the offset relative to the next
+ * block, to continue the ramp.
+ */
+enum ent_error ent_process_events(struct entropictron *ent,
+                                  float** data,
+                                  size_t size,
+                                  const struct ent_event *events,
+                                  size_t count);
+
 void ent_press_key(struct entropictron *ent, bool on, int pitch, int velocity);
 
 struct ent_noise* ent_get_noise(struct entropictron *ent, int id);
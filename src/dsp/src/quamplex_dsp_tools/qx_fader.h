@@ -53,6 +53,23 @@ typedef struct qx_fader {
         bool enabled;    /**< Target state: true = fade in, false = fade out */
 } qx_fader;
 
+/**
+ * @brief Set the fade time.
+ *
+ * @param fader Pointer to qx_fader struct.
+ * @param fadeTime Time to fade in milliseconds.
+ * @param sampleRate Audio sample rate.
+ *
+ * Recomputes the per-sample step, the current fade value is kept.
+ */
+static inline void qx_fader_set_time(struct qx_fader* fader, float fadeTime, float sample_rate)
+{
+        if (fadeTime <= 0.0f)
+                fader->step = 1.0f; // instant fade
+        else
+                fader->step = 1.0f / ((fadeTime / 1000.0f) * sample_rate);
+}
+
 /**
  * @brief Initialize a fader.
  *
@@ -67,11 +84,7 @@ static inline void qx_fader_init(struct qx_fader* fader, float fadeTime, float s
 {
         fader->fade = 0.0f;
         fader->enabled = false;
-
-        if (fadeTime <= 0.0f)
-                fader->step = 1.0f; // instant fade
-        else
-                fader->step = 1.0f / ((fadeTime / 1000.0f) * sample_rate);
+        qx_fader_set_time(fader, fadeTime, sample_rate);
 }
 
 /**
@@ -106,6 +119,21 @@ static inline float qx_fader_fade(struct qx_fader* fader, float val)
         return val * fader->fade;
 }
 
+/**
+ * @brief Advance the fade over silent samples.
+ *
+ * @param fader Pointer to qx_fader struct.
+ * @param n Number of samples.
+ *
+ * Same as calling qx_fader_fade() n times with zero input.
+ */
+static inline void qx_fader_skip(struct qx_fader* fader, size_t n)
+{
+        const float delta = (float)n * fader->step;
+        fader->fade += fader->enabled ? delta : -delta;
+        fader->fade = qx_clamp_float(fader->fade, 0.0f, 1.0f);
+}
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
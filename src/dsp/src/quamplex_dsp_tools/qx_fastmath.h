@@ -0,0 +1,122 @@
+/**
+ * @file qx_fastmath.h
+ * @brief Fast approximations of elementary functions.
+ *
+ * This header provides approximations of tanf and expf for computing
+ * filter coefficients at block rate or sample rate, where the libm
+ * functions are a measurable share of the processing time. The error
+ * bounds below are the maximum relative errors measured against the
+ * double precision functions, in single precision arithmetic.
+ *
+ * Project: Quamplex DSP Tools (A small C library of tools for audio DSP processing)
+ * Website: https://quamplex.com
+ *
+ * Copyright (C) 2025 Iurie Nistor
+ *
+ * This file is part of Quamplex DSP Tools.
+ *
+ * Quamplex DSP Tools is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef QX_FASTMATH_H
+#define QX_FASTMATH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @brief Fast tangent.
+ *
+ * Lambert's continued fraction of tan(x) truncated to a rational
+ * function of degree 7/6, a single division and no range reduction.
+ *
+ * Relative error below 3e-6 for x in [0, 0.49 * pi], the range of
+ * the bilinear prewarping tan(pi * fc / fs) for fc up to 0.49 * fs,
+ * and below 3e-7 for x in [0, pi / 4].
+ *
+ * @param x Angle in radians, |x| < pi / 2.
+ * @return Approximation of tanf(x).
+ */
+static inline float qx_fast_tanf(float x)
+{
+        const float x2 = x * x;
+        const float num = x * (135135.0f + x2 * (-17325.0f + x2 * (378.0f - x2)));
+        const float den = 135135.0f + x2 * (-62370.0f + x2 * (3150.0f - 28.0f * x2));
+        return num / den;
+}
+
+/**
+ * @brief Fast base-2 exponential.
+ *
+ * The argument is split into the nearest integer n and the fraction
+ * f in [-0.5, 0.5], 2^f is computed by its degree 6 Taylor polynomial
+ * and 2^n is added to the exponent bits.
+ *
+ * Relative error below 3e-7.
+ *
+ * @param x Exponent, clamped to [-126, 127].
+ * @return Approximation of exp2f(x).
+ */
+static inline float qx_fast_exp2f(float x)
+{
+        if (x < -126.0f)
+                x = -126.0f;
+        else if (x > 127.0f)
+                x = 127.0f;
+
+        const float n = rintf(x);
+        const float f = x - n;
+        const float p = 1.0f + f * (0.693147181f
+                        + f * (0.240226507f
+                        + f * (0.0555041087f
+                        + f * (0.00961812911f
+                        + f * (0.00133335581f
+                        + f * 0.000154035304f)))));
+
+        int32_t bits;
+        memcpy(&bits, &p, sizeof(bits));
+        bits += (int32_t)n * (1 << 23);
+        float res;
+        memcpy(&res, &bits, sizeof(res));
+        return res;
+}
+
+/**
+ * @brief Fast natural exponential.
+ *
+ * Computed as qx_fast_exp2f(x * log2(e)), the rounding of the product
+ * adds a relative error proportional to |x|.
+ *
+ * Relative error below 7e-7 for |x| <= 10 and below 5e-6 for
+ * |x| <= 87.
+ *
+ * @param x Exponent.
+ * @return Approximation of expf(x).
+ */
+static inline float qx_fast_expf(float x)
+{
+        return qx_fast_exp2f(x * 1.44269504f);
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // QX_FASTMATH_H
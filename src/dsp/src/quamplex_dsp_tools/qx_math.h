@@ -36,6 +36,7 @@ extern "C" {
 #endif
 
 #include <math.h>
+#include <stddef.h>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -63,6 +64,20 @@ extern "C" {
  */
 #define QX_CLAMP(value, min, max) ((value) < (min) ? (min) : ((value) > (max) ? (max) : (value)))
 
+/**
+ * @brief Returns the smaller of two values.
+ *
+ * @note The arguments are evaluated twice.
+ */
+#define QX_MIN(a, b) ((a) < (b) ? (a) : (b))
+
+/**
+ * @brief Returns the larger of two values.
+ *
+ * @note The arguments are evaluated twice.
+ */
+#define QX_MAX(a, b) ((a) > (b) ? (a) : (b))
+
 /**
  * @brief Normalize a float value to the range [0.0, 1.0].
  *
@@ -187,6 +202,7 @@ static inline float qx_ring_interp_linear(const float *buf,
                                           int size)
 {
         int i1 = (int)index;
+        float k = index - (float)i1;
         int i2 = i1 + 1;
 
         if (i1 >= size)
@@ -195,11 +211,138 @@ static inline float qx_ring_interp_linear(const float *buf,
         if (i2 >= size)
                 i2 -= size;
 
-        float k = index - (float)i1;
-
         return buf[i1] + k * (buf[i2] - buf[i1]);
 }
 
+/**
+ * @brief Number of samples gathered at once by the ring readers.
+ */
+#define QX_RING_READ_CHUNK 64
+
+/**
+ * @brief Splits the read positions of a chunk into the integer part
+ * relative to the returned base index and the fraction.
+ *
+ * The positions are computed in float relative to the lowest position
+ * of the chunk, so they stay non-negative and small enough for full
+ * precision, and the loop vectorizes.
+ */
+static inline size_t qx_ring_read_positions(double pos,
+                                            double step,
+                                            int *whole,
+                                            float *frac,
+                                            size_t n)
+{
+        double low = (step < 0.0) ? pos + (double)(n - 1) * step : pos;
+        long long base = (long long)low;
+        float offset = (float)(pos - (double)base);
+        float fstep = (float)step;
+
+        // An int counter, the conversion of size_t doesn't vectorize.
+        for (int i = 0; i < (int)n; i++) {
+                float p = offset + (float)i * fstep;
+                // Rounding can take the lowest position just below zero.
+                if (p < 0.0f)
+                        p = 0.0f;
+                whole[i] = (int)p;
+                frac[i] = p - (float)whole[i];
+        }
+
+        return (size_t)base;
+}
+
+/**
+ * @brief Reads n samples from a power-of-two ring buffer with linear
+ * interpolation, starting at pos and advancing by step per sample.
+ *
+ * The positions and the interpolation run as vectorizable loops over
+ * chunks of samples, only the taps are gathered one by one.
+ *
+ * @param buf Pointer to the buffer.
+ * @param mask Size of the buffer minus one, the size is a power of two.
+ * @param pos Read position of the first sample, must stay non-negative
+ *        over the read (add the buffer size to wrap it forward).
+ * @param step Position increment per sample, negative reads backwards.
+ * @param out Output samples.
+ * @param n Number of samples.
+ */
+static inline void qx_ring_read_linear(const float *buf,
+                                       size_t mask,
+                                       double pos,
+                                       double step,
+                                       float *out,
+                                       size_t n)
+{
+        int whole[QX_RING_READ_CHUNK];
+        float frac[QX_RING_READ_CHUNK];
+        float x0[QX_RING_READ_CHUNK];
+        float x1[QX_RING_READ_CHUNK];
+
+        for (size_t start = 0; start < n; start += QX_RING_READ_CHUNK) {
+                size_t m = n - start;
+                if (m > QX_RING_READ_CHUNK)
+                        m = QX_RING_READ_CHUNK;
+
+                size_t base = qx_ring_read_positions(pos + (double)start * step,
+                                                     step, whole, frac, m);
+                for (size_t i = 0; i < m; i++) {
+                        size_t index = base + (size_t)whole[i];
+                        x0[i] = buf[index & mask];
+                        x1[i] = buf[(index + 1) & mask];
+                }
+
+                float *y = out + start;
+                for (size_t i = 0; i < m; i++)
+                        y[i] = x0[i] + frac[i] * (x1[i] - x0[i]);
+        }
+}
+
+/**
+ * @brief Reads n samples from a power-of-two ring buffer with 4-point,
+ * 3rd-order Hermite interpolation.
+ *
+ * Same arguments as qx_ring_read_linear(). The taps are the sample
+ * before the read position and the three after it.
+ */
+static inline void qx_ring_read_hermite(const float *buf,
+                                        size_t mask,
+                                        double pos,
+                                        double step,
+                                        float *out,
+                                        size_t n)
+{
+        int whole[QX_RING_READ_CHUNK];
+        float frac[QX_RING_READ_CHUNK];
+        float xm1[QX_RING_READ_CHUNK];
+        float x0[QX_RING_READ_CHUNK];
+        float x1[QX_RING_READ_CHUNK];
+        float x2[QX_RING_READ_CHUNK];
+
+        for (size_t start = 0; start < n; start += QX_RING_READ_CHUNK) {
+                size_t m = n - start;
+                if (m > QX_RING_READ_CHUNK)
+                        m = QX_RING_READ_CHUNK;
+
+                size_t base = qx_ring_read_positions(pos + (double)start * step,
+                                                     step, whole, frac, m);
+                for (size_t i = 0; i < m; i++) {
+                        size_t index = base + (size_t)whole[i];
+                        xm1[i] = buf[(index - 1) & mask];
+                        x0[i]  = buf[index & mask];
+                        x1[i]  = buf[(index + 1) & mask];
+                        x2[i]  = buf[(index + 2) & mask];
+                }
+
+                float *y = out + start;
+                for (size_t i = 0; i < m; i++) {
+                        float c1 = 0.5f * (x1[i] - xm1[i]);
+                        float c2 = xm1[i] - 2.5f * x0[i] + 2.0f * x1[i] - 0.5f * x2[i];
+                        float c3 = 0.5f * (x2[i] - xm1[i]) + 1.5f * (x0[i] - x1[i]);
+                        y[i] = ((c3 * frac[i] + c2) * frac[i] + c1) * frac[i] + x0[i];
+                }
+        }
+}
+
 /**
  * @brief Wrap a floating-point value into the range [0, max).
  *
@@ -27,10 +27,19 @@
 #ifndef QX_RANDOMIZER_H
 #define QX_RANDOMIZER_H
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdatomic.h>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -60,6 +69,23 @@ struct qx_randomizer {
     int max_steps;         /**< Cached: number of quantization steps. */
 };
 
+// Linear congruential generator constants.
+#define QX_RANDOMIZER_LCG_MUL 1664525u
+#define QX_RANDOMIZER_LCG_ADD 1013904223u
+
+// Number of seeds advanced in parallel by qx_randomizer_fill().
+#define QX_RANDOMIZER_LANES 8
+
+// LCG constants advancing the seed by QX_RANDOMIZER_LANES steps at once.
+#define QX_RANDOMIZER_LCG_MUL_LANES 0xea890021u
+#define QX_RANDOMIZER_LCG_ADD_LANES 0xa3d95fa8u
+
+// Multiplicative inverse of QX_RANDOMIZER_LCG_MUL modulo 2^32.
+#define QX_RANDOMIZER_LCG_MUL_INV 0xfee058c5u
+
+// Size of the qx_random_buffer.
+#define QX_RANDOM_BUFFER_SIZE 64
+
 /**
  * @brief Global atomic seed used for generating unique seeds via SplitMix32.
  *
@@ -171,7 +197,7 @@ static inline void qx_randomizer_set_resolution(struct qx_randomizer* rand, floa
  */
 static inline float qx_randomizer_get_float(struct qx_randomizer* rand)
 {
-    rand->seed = rand->seed * 1664525u + 1013904223u;
+    rand->seed = rand->seed * QX_RANDOMIZER_LCG_MUL + QX_RANDOMIZER_LCG_ADD;
 
     float normalized = rand->seed * rand->inv_max_uint;
     int step = (int)(normalized * (rand->max_steps + 1));
@@ -182,6 +208,212 @@ static inline float qx_randomizer_get_float(struct qx_randomizer* rand)
     return rand->min + step * rand->resolution;
 }
 
+#if defined(__SSE2__) && !defined(__AVX2__)
+/**
+ * @brief 32-bit lane multiplication, SSE2 has only the 32x32->64 bit one.
+ */
+static inline __m128i qx_randomizer_mullo_sse2(__m128i a, __m128i b)
+{
+        __m128i even = _mm_mul_epu32(a, b);
+        __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+        return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                                  _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+/**
+ * @brief Maps 4 seeds to the output range, like qx_randomizer_get_float().
+ *
+ * SSE2 has only signed conversion, the seed is converted in two 16-bit
+ * halves. The sum is rounded once, so it equals the direct conversion.
+ */
+static inline __m128 qx_randomizer_map_sse2(__m128i seeds,
+                                            __m128 inv_max_uint,
+                                            __m128 steps,
+                                            __m128 max_steps,
+                                            __m128 min,
+                                            __m128 resolution)
+{
+        __m128 hi = _mm_cvtepi32_ps(_mm_srli_epi32(seeds, 16));
+        __m128 lo = _mm_cvtepi32_ps(_mm_and_si128(seeds, _mm_set1_epi32(0xffff)));
+        __m128 normalized = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(hi, _mm_set1_ps(65536.0f)), lo),
+                                       inv_max_uint);
+        __m128 step = _mm_cvtepi32_ps(_mm_cvttps_epi32(_mm_mul_ps(normalized, steps)));
+        step = _mm_min_ps(step, max_steps);
+        return _mm_add_ps(min, _mm_mul_ps(step, resolution));
+}
+#endif // __SSE2__
+
+/**
+ * @brief Fills the output advancing QX_RANDOMIZER_LANES seeds in parallel.
+ *
+ * @param seeds The seeds of the next QX_RANDOMIZER_LANES values,
+ *              updated to the seeds following the generated values.
+ * @param n Number of values, a multiple of QX_RANDOMIZER_LANES.
+ */
+static inline void qx_randomizer_fill_lanes(const struct qx_randomizer* rand,
+                                            uint32_t *seeds,
+                                            float *out,
+                                            size_t n)
+{
+#if defined(__AVX2__)
+        const __m256i mul = _mm256_set1_epi32((int)QX_RANDOMIZER_LCG_MUL_LANES);
+        const __m256i add = _mm256_set1_epi32((int)QX_RANDOMIZER_LCG_ADD_LANES);
+        const __m256 inv_max_uint = _mm256_set1_ps(rand->inv_max_uint);
+        const __m256 steps = _mm256_set1_ps((float)(rand->max_steps + 1));
+        const __m256 max_steps = _mm256_set1_ps((float)rand->max_steps);
+        const __m256 min = _mm256_set1_ps(rand->min);
+        const __m256 resolution = _mm256_set1_ps(rand->resolution);
+        __m256i s = _mm256_loadu_si256((const __m256i*)seeds);
+        for (size_t i = 0; i < n; i += QX_RANDOMIZER_LANES) {
+                __m256 hi = _mm256_cvtepi32_ps(_mm256_srli_epi32(s, 16));
+                __m256 lo = _mm256_cvtepi32_ps(_mm256_and_si256(s, _mm256_set1_epi32(0xffff)));
+                __m256 normalized = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(hi, _mm256_set1_ps(65536.0f)), lo),
+                                                  inv_max_uint);
+                __m256 step = _mm256_cvtepi32_ps(_mm256_cvttps_epi32(_mm256_mul_ps(normalized, steps)));
+                step = _mm256_min_ps(step, max_steps);
+                _mm256_storeu_ps(out + i, _mm256_add_ps(min, _mm256_mul_ps(step, resolution)));
+                s = _mm256_add_epi32(_mm256_mullo_epi32(s, mul), add);
+        }
+        _mm256_storeu_si256((__m256i*)seeds, s);
+#elif defined(__SSE2__)
+        const __m128i mul = _mm_set1_epi32((int)QX_RANDOMIZER_LCG_MUL_LANES);
+        const __m128i add = _mm_set1_epi32((int)QX_RANDOMIZER_LCG_ADD_LANES);
+        const __m128 inv_max_uint = _mm_set1_ps(rand->inv_max_uint);
+        const __m128 steps = _mm_set1_ps((float)(rand->max_steps + 1));
+        const __m128 max_steps = _mm_set1_ps((float)rand->max_steps);
+        const __m128 min = _mm_set1_ps(rand->min);
+        const __m128 resolution = _mm_set1_ps(rand->resolution);
+        __m128i s0 = _mm_loadu_si128((const __m128i*)seeds);
+        __m128i s1 = _mm_loadu_si128((const __m128i*)(seeds + 4));
+        for (size_t i = 0; i < n; i += QX_RANDOMIZER_LANES) {
+                _mm_storeu_ps(out + i, qx_randomizer_map_sse2(s0, inv_max_uint, steps,
+                                                              max_steps, min, resolution));
+                _mm_storeu_ps(out + i + 4, qx_randomizer_map_sse2(s1, inv_max_uint, steps,
+                                                                  max_steps, min, resolution));
+                s0 = _mm_add_epi32(qx_randomizer_mullo_sse2(s0, mul), add);
+                s1 = _mm_add_epi32(qx_randomizer_mullo_sse2(s1, mul), add);
+        }
+        _mm_storeu_si128((__m128i*)seeds, s0);
+        _mm_storeu_si128((__m128i*)(seeds + 4), s1);
+#elif defined(__ARM_NEON)
+        const uint32x4_t mul = vdupq_n_u32(QX_RANDOMIZER_LCG_MUL_LANES);
+        const uint32x4_t add = vdupq_n_u32(QX_RANDOMIZER_LCG_ADD_LANES);
+        const float32x4_t inv_max_uint = vdupq_n_f32(rand->inv_max_uint);
+        const float32x4_t steps = vdupq_n_f32((float)(rand->max_steps + 1));
+        const float32x4_t max_steps = vdupq_n_f32((float)rand->max_steps);
+        const float32x4_t min = vdupq_n_f32(rand->min);
+        const float32x4_t resolution = vdupq_n_f32(rand->resolution);
+        uint32x4_t s[2] = {vld1q_u32(seeds), vld1q_u32(seeds + 4)};
+        for (size_t i = 0; i < n; i += QX_RANDOMIZER_LANES) {
+                for (size_t k = 0; k < 2; k++) {
+                        float32x4_t normalized = vmulq_f32(vcvtq_f32_u32(s[k]), inv_max_uint);
+                        float32x4_t step = vcvtq_f32_s32(vcvtq_s32_f32(vmulq_f32(normalized, steps)));
+                        step = vminq_f32(step, max_steps);
+                        vst1q_f32(out + i + 4 * k, vaddq_f32(min, vmulq_f32(step, resolution)));
+                        s[k] = vaddq_u32(vmulq_u32(s[k], mul), add);
+                }
+        }
+        vst1q_u32(seeds, s[0]);
+        vst1q_u32(seeds + 4, s[1]);
+#else
+        for (size_t i = 0; i < n; i += QX_RANDOMIZER_LANES) {
+                for (size_t k = 0; k < QX_RANDOMIZER_LANES; k++) {
+                        float normalized = seeds[k] * rand->inv_max_uint;
+                        int step = (int)(normalized * (rand->max_steps + 1));
+                        if (step > rand->max_steps)
+                                step = rand->max_steps;
+                        out[i + k] = rand->min + step * rand->resolution;
+                        seeds[k] = seeds[k] * QX_RANDOMIZER_LCG_MUL_LANES + QX_RANDOMIZER_LCG_ADD_LANES;
+                }
+        }
+#endif
+}
+
+/**
+ * @brief Fills a buffer with random values.
+ *
+ * @param rand Pointer to an initialized `qx_randomizer`.
+ * @param out Output buffer.
+ * @param n Number of values.
+ *
+ * Produces the same values as n calls of qx_randomizer_get_float(),
+ * but advances QX_RANDOMIZER_LANES seeds in parallel using SIMD lanes
+ * (AVX2, SSE2 or NEON, depending on the build target).
+ */
+static inline void qx_randomizer_fill(struct qx_randomizer* rand, float *out, size_t n)
+{
+        size_t i = 0;
+        if (n >= QX_RANDOMIZER_LANES) {
+                uint32_t seeds[QX_RANDOMIZER_LANES];
+                uint32_t seed = rand->seed;
+                for (size_t k = 0; k < QX_RANDOMIZER_LANES; k++) {
+                        seed = seed * QX_RANDOMIZER_LCG_MUL + QX_RANDOMIZER_LCG_ADD;
+                        seeds[k] = seed;
+                }
+
+                i = n - n % QX_RANDOMIZER_LANES;
+                qx_randomizer_fill_lanes(rand, seeds, out, i);
+
+                // Step back from the first seed not used.
+                rand->seed = (seeds[0] - QX_RANDOMIZER_LCG_ADD) * QX_RANDOMIZER_LCG_MUL_INV;
+        }
+
+        for (; i < n; i++)
+                out[i] = qx_randomizer_get_float(rand);
+}
+
+/**
+ * @brief Buffer of random values generated in blocks.
+ *
+ * For random values used at irregular times, e.g. only when an
+ * event starts. The values are the same as the ones returned by
+ * qx_randomizer_get_float(), the randomizer is ahead of the buffer.
+ */
+struct qx_random_buffer {
+        float values[QX_RANDOM_BUFFER_SIZE];
+        size_t pos;
+};
+
+static inline void qx_random_buffer_init(struct qx_random_buffer* buffer)
+{
+        buffer->pos = QX_RANDOM_BUFFER_SIZE;
+}
+
+/**
+ * @brief Returns the next random value, refilling the buffer when empty.
+ */
+static inline float qx_random_buffer_next(struct qx_random_buffer* buffer,
+                                          struct qx_randomizer* rand)
+{
+        if (buffer->pos >= QX_RANDOM_BUFFER_SIZE) {
+                qx_randomizer_fill(rand, buffer->values, QX_RANDOM_BUFFER_SIZE);
+                buffer->pos = 0;
+        }
+
+        return buffer->values[buffer->pos++];
+}
+
+/**
+ * @brief Returns the next random value if take is true, otherwise 0.
+ *
+ * The same values as qx_random_buffer_next() called only when take is
+ * true, without a branch on take, for values taken with a random
+ * probability.
+ */
+static inline float qx_random_buffer_next_if(struct qx_random_buffer* buffer,
+                                             struct qx_randomizer* rand,
+                                             bool take)
+{
+        if (buffer->pos >= QX_RANDOM_BUFFER_SIZE) {
+                qx_randomizer_fill(rand, buffer->values, QX_RANDOM_BUFFER_SIZE);
+                buffer->pos = 0;
+        }
+
+        const float val = buffer->values[buffer->pos];
+        buffer->pos += take;
+        return take ? val : 0.0f;
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -65,6 +65,17 @@ static inline void qx_smoother_init(qx_smoother* s, float initial, size_t frames
     s->step = 0.0f;
 }
 
+/**
+ * @brief Set the number of frames over which the next targets are reached.
+ *
+ * @param s Pointer to qx_smoother
+ * @param frames Number of frames (samples or blocks) over which to smooth
+ */
+static inline void qx_smoother_set_frames(qx_smoother* s, size_t frames)
+{
+    s->frames = frames > 0 ? frames : 1;
+}
+
 /**
  * @brief Set a new target value.
  *
@@ -99,6 +110,29 @@ static inline float qx_smoother_next(qx_smoother* s)
     return s->current;
 }
 
+/**
+ * @brief Advance the smoother by the given number of frames at once.
+ *
+ * @param s Pointer to qx_smoother
+ * @param frames Number of frames to advance
+ * @return Smoothed value after the frames
+ */
+static inline float qx_smoother_skip(qx_smoother* s, size_t frames)
+{
+    if (s->current == s->target)
+        return s->current;
+
+    s->current += s->step * (float)frames;
+
+    // Clamp to target to avoid overshoot
+    if ((s->step > 0.0f && s->current > s->target) ||
+        (s->step < 0.0f && s->current < s->target)) {
+        s->current = s->target;
+    }
+
+    return s->current;
+}
+
 /**
  * @brief Get current value without advancing.
  *
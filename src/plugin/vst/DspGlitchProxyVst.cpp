@@ -396,3 +396,45 @@ double DspGlitchProxyVst::wetFromNormalized(double normalized)
                               ENT_GLITCH_MIN_WET,
                               ENT_GLITCH_MAX_WET);
 }
+
+double DspGlitchProxyVst::crossfadeToNormalized(double value)
+{
+        return toNormalized(value,
+                            ENT_GLITCH_MIN_CROSSFADE,
+                            ENT_GLITCH_MAX_CROSSFADE);
+}
+
+double DspGlitchProxyVst::crossfadeFromNormalized(double normalized)
+{
+        return fromNormalized(normalized,
+                              ENT_GLITCH_MIN_CROSSFADE,
+                              ENT_GLITCH_MAX_CROSSFADE);
+}
+
+double DspGlitchProxyVst::speedToNormalized(double value)
+{
+        return toNormalized(value,
+                            ENT_GLITCH_MIN_SPEED,
+                            ENT_GLITCH_MAX_SPEED);
+}
+
+double DspGlitchProxyVst::speedFromNormalized(double normalized)
+{
+        return fromNormalized(normalized,
+                              ENT_GLITCH_MIN_SPEED,
+                              ENT_GLITCH_MAX_SPEED);
+}
+
+double DspGlitchProxyVst::interpolationToNormalized(int value)
+{
+        return toNormalized(static_cast<double>(value),
+                            0,
+                            ENT_GLITCH_INTERP_NUM_TYPES - 1);
+}
+
+int DspGlitchProxyVst::interpolationFromNormalized(double normalized)
+{
+        return static_cast<int>(std::round(fromNormalized(normalized,
+                                                          0,
+                                                          ENT_GLITCH_INTERP_NUM_TYPES - 1)));
+}
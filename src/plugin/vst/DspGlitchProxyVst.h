@@ -70,6 +70,12 @@ class DspGlitchProxyVst: public DspGlitchProxy {
         static double dryFromNormalized(double normalized);
         static double wetToNormalized(double value);
         static double wetFromNormalized(double normalized);
+        static double crossfadeToNormalized(double value);
+        static double crossfadeFromNormalized(double normalized);
+        static double speedToNormalized(double value);
+        static double speedFromNormalized(double normalized);
+        static double interpolationToNormalized(int value);
+        static int interpolationFromNormalized(double normalized);
 protected:
         void onParameterChanged(ParameterId paramId, ParamValue value);
 
@@ -160,6 +160,12 @@ EntVstController::initialize(FUnknown* context)
                            DspGlitchProxyVst::dryToNormalized(ENT_GLITCH_DEFAULT_DRY));
         setParamNormalized(ParameterId::Glitch1WetId,
                            DspGlitchProxyVst::wetToNormalized(ENT_GLITCH_DEFAULT_WET));
+        setParamNormalized(ParameterId::Glitch1CrossfadeId,
+                           DspGlitchProxyVst::crossfadeToNormalized(ENT_GLITCH_DEFAULT_CROSSFADE));
+        setParamNormalized(ParameterId::Glitch1SpeedId,
+                           DspGlitchProxyVst::speedToNormalized(ENT_GLITCH_DEFAULT_SPEED));
+        setParamNormalized(ParameterId::Glitch1InterpolationId,
+                           DspGlitchProxyVst::interpolationToNormalized(ENT_GLITCH_DEFAULT_INTERP));
 
         // Glitch2
         setParamNormalized(ParameterId::Glitch2EnabledId, 0);
@@ -177,6 +183,12 @@ EntVstController::initialize(FUnknown* context)
                            DspGlitchProxyVst::dryToNormalized(ENT_GLITCH_DEFAULT_DRY));
         setParamNormalized(ParameterId::Glitch2WetId,
                            DspGlitchProxyVst::wetToNormalized(ENT_GLITCH_DEFAULT_WET));
+        setParamNormalized(ParameterId::Glitch2CrossfadeId,
+                           DspGlitchProxyVst::crossfadeToNormalized(ENT_GLITCH_DEFAULT_CROSSFADE));
+        setParamNormalized(ParameterId::Glitch2SpeedId,
+                           DspGlitchProxyVst::speedToNormalized(ENT_GLITCH_DEFAULT_SPEED));
+        setParamNormalized(ParameterId::Glitch2InterpolationId,
+                           DspGlitchProxyVst::interpolationToNormalized(ENT_GLITCH_DEFAULT_INTERP));
 
         // Rgate
         setParamNormalized(ParameterId::RgateEnabledId,
@@ -351,6 +363,12 @@ void EntVstController::setGlitchState(const EntState &state)
                                     DspGlitchProxyVst::dryToNormalized(glitch.dry));
                 setParamNormalized (ParameterId::Glitch1WetId,
                                     DspGlitchProxyVst::dryToNormalized(glitch.wet));
+                setParamNormalized (ParameterId::Glitch1CrossfadeId,
+                                    DspGlitchProxyVst::crossfadeToNormalized(glitch.crossfade));
+                setParamNormalized (ParameterId::Glitch1SpeedId,
+                                    DspGlitchProxyVst::speedToNormalized(glitch.speed));
+                setParamNormalized (ParameterId::Glitch1InterpolationId,
+                                    DspGlitchProxyVst::interpolationToNormalized(glitch.interpolation));
         }
 
         {
@@ -370,6 +388,12 @@ void EntVstController::setGlitchState(const EntState &state)
                                     DspGlitchProxyVst::dryToNormalized(glitch.dry));
                 setParamNormalized (ParameterId::Glitch2WetId,
                                     DspGlitchProxyVst::dryToNormalized(glitch.wet));
+                setParamNormalized (ParameterId::Glitch2CrossfadeId,
+                                    DspGlitchProxyVst::crossfadeToNormalized(glitch.crossfade));
+                setParamNormalized (ParameterId::Glitch2SpeedId,
+                                    DspGlitchProxyVst::speedToNormalized(glitch.speed));
+                setParamNormalized (ParameterId::Glitch2InterpolationId,
+                                    DspGlitchProxyVst::interpolationToNormalized(glitch.interpolation));
         }
 }
 
@@ -638,6 +662,27 @@ void EntVstController::addGlitchParameters()
                                 ParameterInfo::kCanAutomate,
                                 ParameterId::Glitch2WetId);
 
+        // Glitch1 Crossfade (ms)
+        parameters.addParameter(STR16("Glitch1 Crossfade"),
+                                STR16("ms"), 0,
+                                DspGlitchProxyVst::crossfadeToNormalized(ENT_GLITCH_DEFAULT_CROSSFADE),
+                                ParameterInfo::kCanAutomate,
+                                ParameterId::Glitch1CrossfadeId);
+
+        // Glitch1 Speed, negative plays in reverse
+        parameters.addParameter(STR16("Glitch1 Speed"),
+                                STR16("x"), 0,
+                                DspGlitchProxyVst::speedToNormalized(ENT_GLITCH_DEFAULT_SPEED),
+                                ParameterInfo::kCanAutomate,
+                                ParameterId::Glitch1SpeedId);
+
+        // Glitch1 Interpolation (Linear/Hermite)
+        parameters.addParameter(STR16("Glitch1 Interpolation"),
+                                nullptr, ENT_GLITCH_INTERP_NUM_TYPES - 1,
+                                DspGlitchProxyVst::interpolationToNormalized(ENT_GLITCH_DEFAULT_INTERP),
+                                ParameterInfo::kCanAutomate,
+                                ParameterId::Glitch1InterpolationId);
+
         // Glitch2 Enabled (On/Off)
         parameters.addParameter(STR16("Glitch2 Enabled"),
                                 nullptr, 2, 0.0,
@@ -690,6 +735,27 @@ void EntVstController::addGlitchParameters()
                                 DspGlitchProxyVst::wetToNormalized(ENT_GLITCH_DEFAULT_WET),
                                 ParameterInfo::kCanAutomate,
                                 ParameterId::Glitch2WetId);
+
+        // Glitch2 Crossfade (ms)
+        parameters.addParameter(STR16("Glitch2 Crossfade"),
+                                STR16("ms"), 0,
+                                DspGlitchProxyVst::crossfadeToNormalized(ENT_GLITCH_DEFAULT_CROSSFADE),
+                                ParameterInfo::kCanAutomate,
+                                ParameterId::Glitch2CrossfadeId);
+
+        // Glitch2 Speed, negative plays in reverse
+        parameters.addParameter(STR16("Glitch2 Speed"),
+                                STR16("x"), 0,
+                                DspGlitchProxyVst::speedToNormalized(ENT_GLITCH_DEFAULT_SPEED),
+                                ParameterInfo::kCanAutomate,
+                                ParameterId::Glitch2SpeedId);
+
+        // Glitch2 Interpolation (Linear/Hermite)
+        parameters.addParameter(STR16("Glitch2 Interpolation"),
+                                nullptr, ENT_GLITCH_INTERP_NUM_TYPES - 1,
+                                DspGlitchProxyVst::interpolationToNormalized(ENT_GLITCH_DEFAULT_INTERP),
+                                ParameterInfo::kCanAutomate,
+                                ParameterId::Glitch2InterpolationId);
 }
 
 void EntVstController::addRgateParameters()
@@ -785,12 +851,28 @@ tresult EntVstController::setParamNormalized (ParamID tag, ParamValue value)
                 return result;
 
         auto parameterId = static_cast<ParameterId>(tag);
+        if ((parameterId == ParameterId::Glitch1EnabledId
+             || parameterId == ParameterId::Glitch2EnabledId) && value > 0.5)
+                requestGlitchHistory();
+
         auto res = parametersCallbacks.find(parameterId);
         if (res != parametersCallbacks.end())
                 res->second(parameterId, value);
         return result;
 }
 
+void EntVstController::requestGlitchHistory()
+{
+        // The processor allocates the glitch history on the main thread
+        // when it receives the message.
+        auto message = owned(allocateMessage());
+        if (!message)
+                return;
+
+        message->setMessageID(EntVstGlitchHistoryMessageId);
+        sendMessage(message);
+}
+
 void EntVstController::restartComponent()
 {
         if (componentHandler)
@@ -64,6 +64,7 @@ protected:
         void addCrackleParameters();
         void addGlitchParameters();
         void addRgateParameters();
+        void requestGlitchHistory();
 
 private:
         std::unordered_map<ParameterId, ParameterCallback> parametersCallbacks;
@@ -88,6 +88,9 @@ enum ParameterId : Steinberg::Vst::ParamID
     Glitch1RepeatsId        = 30106,
     Glitch1DryId            = 30107,
     Glitch1WetId            = 30108,
+    Glitch1CrossfadeId      = 30109,
+    Glitch1SpeedId          = 30110,
+    Glitch1InterpolationId  = 30111,
 
     // Glitcher 2
     Glitch2EnabledId        = 30201,
@@ -98,6 +101,9 @@ enum ParameterId : Steinberg::Vst::ParamID
     Glitch2RepeatsId        = 30206,
     Glitch2DryId            = 30207,
     Glitch2WetId            = 30208,
+    Glitch2CrossfadeId      = 30209,
+    Glitch2SpeedId          = 30210,
+    Glitch2InterpolationId  = 30211,
 
     // Rgate
     RgateEnabledId          = 30301,
@@ -25,7 +25,6 @@
 #include "EntVstPluginView.h"
 #include "VstIds.h"
 #include "DspWrapper.h"
-#include "DspFrameTimer.h"
 #include "DspWrapperNoise.h"
 #include "DspWrapperCrackle.h"
 #include "DspWrapperGlitch.h"
@@ -43,6 +42,11 @@
 #include "pluginterfaces/base/ibstream.h"
 #include "pluginterfaces/vst/ivstparameterchanges.h"
 #include "pluginterfaces/vst/ivstevents.h"
+#include "pluginterfaces/vst/ivstmessage.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
 
 using namespace EntVst;
 using namespace Steinberg::Vst;
@@ -64,22 +68,19 @@ EntVstProcessor::EntVstProcessor()
         , dspStateUpdated{false}
         , isPendingState{false}
         , dspState{ent_state_create()}
-        , eventCount{0}
+        , rampEventCount{0}
+        , droppedEvents{0}
+        , steppedRampEvents{0}
+        , glitchHistoryRequested{false}
+        , isServiceStopped{true}
 {
-        entropictronDsp->getFrameTimer()->setOnTimeoutCallback([this](size_t i) {
-                QueuedEvent qe;
-                qe.type = QueuedEvent::Type::DspTimer;
-                qe.sampleOffset = i;
-                if (eventCount < eventQueue.max_size())
-                        eventQueue[eventCount++] = qe;
-        });
-
         entropictronDsp->getState(dspState);
         initParamMappings();
 }
 
 EntVstProcessor::~EntVstProcessor()
 {
+        stopService();
         ent_state_free(dspState);
 }
 
@@ -112,6 +113,7 @@ EntVstProcessor::initialize(FUnknown* context)
 
 tresult PLUGIN_API EntVstProcessor::terminate()
 {
+        stopService();
         entropictronDsp.reset();
         return AudioEffect::terminate();
 }
@@ -131,14 +133,56 @@ EntVstProcessor::setBusArrangements(SpeakerArrangement* inputs,
 tresult PLUGIN_API
 EntVstProcessor::setupProcessing(ProcessSetup& setup)
 {
-        if (entropictronDsp)
-                entropictronDsp->setSampleRate(setup.sampleRate);
+        if (entropictronDsp) {
+                // The new rate is applied by the audio thread on the next process().
+                if (!entropictronDsp->prepare(setup.sampleRate, setup.maxSamplesPerBlock)) {
+                        ENT_LOG_ERROR("can't prepare DSP for sample rate " << setup.sampleRate);
+                        return kResultFalse;
+                }
+                // Bounces render the modules on worker threads, the
+                // realtime processing stays on the audio thread.
+                bool offline = setup.processMode == kOffline;
+                if (offline || entropictronDsp->isGlitchHistoryNeeded()) {
+                        // A bounce can't wait for the service thread, the history
+                        // is allocated in advance for a glitch enabled later.
+                        allocateGlitchHistory();
+                }
+
+                size_t workers = 0;
+                if (offline && std::thread::hardware_concurrency() > 1)
+                        workers = std::thread::hardware_concurrency() - 1;
+                if (!entropictronDsp->setWorkerThreads(workers))
+                        ENT_LOG_ERROR("can't create DSP worker threads");
+                entropictronDsp->setOffline(offline);
+        }
         return AudioEffect::setupProcessing(setup);
 }
 
 tresult PLUGIN_API
 EntVstProcessor::setActive(TBool state)
 {
+        if (state && entropictronDsp) {
+                if (entropictronDsp->isGlitchHistoryNeeded())
+                        allocateGlitchHistory();
+#ifdef ENT_LOCK_MEMORY
+                if (!entropictronDsp->isMemoryLocked()
+                    && !entropictronDsp->setMemoryLock(true))
+                        ENT_LOG_ERROR("can't lock DSP memory");
+#endif // ENT_LOCK_MEMORY
+                entropictronDsp->prefaultMemory();
+                ENT_LOG_DEBUG("DSP memory: " << entropictronDsp->getMemorySize()
+                             << " bytes, locked: " << (entropictronDsp->isMemoryLocked() ? "yes" : "no"));
+                startService();
+        } else if (!state) {
+                stopService();
+                auto dropped = droppedEvents.exchange(0, std::memory_order_relaxed);
+                if (dropped > 0)
+                        ENT_LOG_ERROR("dropped " << dropped << " automation points, too many parameter queues");
+                auto stepped = steppedRampEvents.exchange(0, std::memory_order_relaxed);
+                if (stepped > 0)
+                        ENT_LOG_DEBUG(stepped << " automation points applied as steps, ramp events full");
+        }
+
         return AudioEffect::setActive(state);
 }
 
@@ -147,13 +191,69 @@ tresult PLUGIN_API EntVstProcessor::setProcessing (TBool state)
         return AudioEffect::setProcessing (state);
 }
 
+tresult PLUGIN_API EntVstProcessor::notify(IMessage* message)
+{
+        if (!message)
+                return kInvalidArgument;
+
+        // The messages are received on the main thread. The message of
+        // the controller allocates the history before process() requests it.
+        if (FIDStringsEqual(message->getMessageID(), EntVstGlitchHistoryMessageId)) {
+                allocateGlitchHistory();
+                return kResultOk;
+        }
+
+        return AudioEffect::notify(message);
+}
+
+void EntVstProcessor::allocateGlitchHistory()
+{
+        std::lock_guard<std::mutex> lock(glitchHistoryMutex);
+        if (entropictronDsp)
+                entropictronDsp->allocateGlitchHistory();
+}
+
+void EntVstProcessor::startService()
+{
+        if (serviceThread.joinable())
+                return;
+
+        isServiceStopped = false;
+        serviceThread = std::thread(&EntVstProcessor::runService, this);
+}
+
+void EntVstProcessor::stopService()
+{
+        if (!serviceThread.joinable())
+                return;
+
+        {
+                std::lock_guard<std::mutex> lock(serviceMutex);
+                isServiceStopped = true;
+        }
+        serviceCondition.notify_one();
+        serviceThread.join();
+}
+
+void EntVstProcessor::runService()
+{
+        // The audio thread only sets the request flag and the service
+        // thread polls it, process() doesn't take locks or wake threads.
+        constexpr auto servicePeriod = std::chrono::milliseconds(20);
+        std::unique_lock<std::mutex> lock(serviceMutex);
+        while (!serviceCondition.wait_for(lock, servicePeriod, [this] { return isServiceStopped; })) {
+                if (glitchHistoryRequested.exchange(false, std::memory_order_acquire))
+                        allocateGlitchHistory();
+        }
+}
+
 tresult PLUGIN_API
 EntVstProcessor::process(ProcessData& data)
  {
          if (!entropictronDsp || data.numSamples < 1)
                  return kResultOk;
 
-         eventCount = 0;
+         rampEventCount = 0;
          memset(data.outputs[0].channelBuffers32[0], 0,
                 data.numSamples * sizeof(float));
          memset(data.outputs[0].channelBuffers32[1], 0,
@@ -169,8 +269,6 @@ EntVstProcessor::process(ProcessData& data)
                  }
          }
 
-         entropictronDsp->getFrameTimer()->process(data.numSamples);
-
          const auto* ctx = data.processContext;
          if (entropictronDsp->playMode() == PlayMode::PlaybackMode && ctx)
                  entropictronDsp->pressKey(ctx->state & ProcessContext::kPlaying);
@@ -184,75 +282,124 @@ EntVstProcessor::process(ProcessData& data)
          if (ok)
                  entropictronDsp->setState(dspState);
 
-         // Collect MIDI events
+         // The glitch enabled by automation outputs only the dry signal
+         // until the service thread allocates its history.
+         if (entropictronDsp->isGlitchHistoryNeeded())
+                 glitchHistoryRequested.store(true, std::memory_order_release);
+
+         // The event list is the source 0 of the merge, the parameter
+         // queue i is the source i + 1. The sources are sorted by offset.
          auto midiEvents = data.inputEvents;
          int32 nMidiEvents = midiEvents ? midiEvents->getEventCount() : 0;
-
-         // Collect automation events
          auto inputParams = data.inputParameterChanges;
-
-         // Insert MIDI events into queue
-         for (int32 i = 0; i < nMidiEvents && eventCount < eventQueue.max_size(); ++i) {
-                 Event event{};
-                 if (midiEvents->getEvent(i, event) == kResultOk) {
-                         QueuedEvent qe;
-                         qe.sampleOffset = event.sampleOffset;
-
-                         switch (event.type) {
-                         case Event::kNoteOnEvent:
-                                 qe.type = QueuedEvent::Type::NoteOn;
-                                 qe.note.pitch = event.noteOn.pitch;
-                                 qe.note.velocity = event.noteOn.velocity;
-                                 qe.note.on = true;
-                                 eventQueue[eventCount++] = qe;
-                                 break;
-
-                         case Event::kNoteOffEvent:
-                                 qe.type = QueuedEvent::Type::NoteOff;
-                                 qe.note.pitch = event.noteOff.pitch;
-                                 qe.note.velocity = event.noteOff.velocity;
-                                 qe.note.on = false;
-                                 eventQueue[eventCount++] = qe;
-                                 break;
-
-                         default:
-                                 break;
+         int32 paramCount = inputParams ? inputParams->getParameterCount() : 0;
+         using Cursor = EventMerger<EVENT_MAX_SOURCES>::Cursor;
+
+         // Finds the first event of the source from the index on and reads
+         // its offset, returns false if the source has no events left.
+         // Only the notes are taken from the event list, the other events
+         // don't change the DSP state and don't split the block. The
+         // points that can't be read are skipped.
+         auto findEvent = [&](int32 source, int32 &index, int32 &offset) {
+                 if (source == 0) {
+                         for (; index < nMidiEvents; ++index) {
+                                 Event event{};
+                                 if (midiEvents->getEvent(index, event) == kResultOk
+                                     && (event.type == Event::kNoteOnEvent
+                                         || event.type == Event::kNoteOffEvent)) {
+                                         offset = event.sampleOffset;
+                                         return true;
+                                 }
                          }
+                         return false;
                  }
-         }
 
-         // Insert automation parameter changes into queue
-         if (inputParams) {
-                 int32 paramCount = inputParams->getParameterCount();
-                 for (int32 i = 0; i < paramCount && eventCount < eventQueue.max_size(); ++i) {
-                         auto queue = inputParams->getParameterData(i);
-                         if (!queue)
-                                 continue;
+                 auto queue = inputParams->getParameterData(source - 1);
+                 int32 pointCount = queue->getPointCount();
+                 for (; index < pointCount; ++index) {
+                         ParamValue value = 0;
+                         if (queue->getPoint(index, offset, value) == kResultOk)
+                                 return true;
+                 }
+                 return false;
+         };
 
-                         ParamID pid = queue->getParameterId();
-                         int32 pointCount = queue->getPointCount();
+         // Moves the merge to the next event of the source of the top event.
+         auto nextEvent = [&](const Cursor &cursor) {
+                 int32 index = cursor.index + 1;
+                 int32 offset = 0;
+                 if (findEvent(cursor.source, index, offset))
+                         eventMerger.next(index, offset);
+                 else
+                         eventMerger.pop();
+         };
 
-                         // Push all points as automation events
-                         for (int32 p = 0; p < pointCount && eventCount < eventQueue.max_size(); ++p) {
-                                 int32 sampleOffset = 0;
-                                 ParamValue value = 0;
-                                 if (queue->getPoint(p, sampleOffset, value) == kResultOk) {
-                                         QueuedEvent qe;
-                                         qe.sampleOffset = sampleOffset;
-                                         qe.type = QueuedEvent::Type::Automation;
-                                         qe.automation.pid = pid;
-                                         qe.automation.value = value;
-                                         eventQueue[eventCount++] = qe;
-                                 }
+         // Adds a parameter queue to the merge. If the merge is full only the
+         // last point of the queue is applied, at the block start.
+         auto mergeQueue = [&](int32 i) {
+                 auto queue = inputParams->getParameterData(i);
+                 int32 index = 0;
+                 int32 offset = 0;
+                 if (findEvent(i + 1, index, offset)
+                     && (i + 1 >= static_cast<int32>(EVENT_MAX_SOURCES)
+                         || !eventMerger.push(i + 1, index, offset))) {
+                         int32 pointCount = queue->getPointCount();
+                         ParamValue value = 0;
+                         if (queue->getPoint(pointCount - 1, offset, value) == kResultOk) {
+                                 updateParameters(static_cast<ParameterId>(queue->getParameterId()), value);
+                                 dspStateUpdated = true;
                          }
+                         droppedEvents.fetch_add(pointCount - 1, std::memory_order_relaxed);
                  }
+         };
+
+         // The points of the continuous parameters are merged first into
+         // the ramp events of the DSP. The points not fitting the ramp events
+         // stay in the merge and are applied as steps with the other events.
+         eventMerger.clear();
+         for (int32 i = 0; i < paramCount; ++i) {
+                 if (i + 1 >= static_cast<int32>(EVENT_MAX_SOURCES))
+                         break;
+
+                 auto queue = inputParams->getParameterData(i);
+                 const RampParam *ramp = nullptr;
+                 if (queue) {
+                         auto it = rampParamMap.find(static_cast<ParameterId>(queue->getParameterId()));
+                         if (it != rampParamMap.end())
+                                 ramp = &it->second;
+                 }
+                 sourceRamps[i + 1] = ramp;
+                 if (ramp)
+                         mergeQueue(i);
          }
 
-         // Sort all events by sampleOffset ascending
-         std::sort(eventQueue.begin(), eventQueue.begin() + eventCount,
-                   [](const QueuedEvent& a, const QueuedEvent& b) {
-                           return a.sampleOffset < b.sampleOffset;
-                   });
+         while (!eventMerger.empty() && rampEventCount < rampEvents.size()) {
+                 auto cursor = eventMerger.top();
+                 auto queue = inputParams->getParameterData(cursor.source - 1);
+                 int32 offset = 0;
+                 ParamValue value = 0;
+                 if (queue->getPoint(cursor.index, offset, value) == kResultOk) {
+                         const RampParam *ramp = sourceRamps[cursor.source];
+                         struct ent_event &event = rampEvents[rampEventCount++];
+                         event.offset = std::clamp(offset, 0, data.numSamples);
+                         event.param = ramp->param;
+                         event.module = ramp->module;
+                         event.value = ramp->fromNormalized(value);
+                 }
+                 nextEvent(cursor);
+         }
+         if (rampEventCount > 0)
+                 dspStateUpdated = true;
+
+         int32 midiIndex = 0;
+         int32 midiOffset = 0;
+         if (findEvent(0, midiIndex, midiOffset))
+                 eventMerger.push(0, midiIndex, midiOffset);
+         for (int32 i = 0; i < paramCount; ++i) {
+                 if (inputParams->getParameterData(i)
+                     && (i + 1 >= static_cast<int32>(EVENT_MAX_SOURCES) || !sourceRamps[i + 1]))
+                         mergeQueue(i);
+         }
 
          float* buffer[4] = {
                  data.inputs[0].channelBuffers32[0],
@@ -261,48 +408,59 @@ EntVstProcessor::process(ProcessData& data)
                  data.outputs[0].channelBuffers32[1]
          };
 
+         // The ramps continue over the chunks, the pending ramp
+         // events are rebased to the start of the next chunk.
+         size_t rampEventIndex = 0;
+         auto processChunk = [&](size_t chunkSize) {
+                 entropictronDsp->process(buffer,
+                                          chunkSize,
+                                          rampEvents.data() + rampEventIndex,
+                                          rampEventCount - rampEventIndex);
+                 for (size_t i = rampEventIndex; i < rampEventCount; ++i) {
+                         if (rampEvents[i].offset < chunkSize)
+                                 rampEventIndex = i + 1;
+                         else
+                                 rampEvents[i].offset -= chunkSize;
+                 }
+                 buffer[0] += chunkSize;
+                 buffer[1] += chunkSize;
+                 buffer[2] += chunkSize;
+                 buffer[3] += chunkSize;
+         };
+
+         // Only the notes and the other parameters split the block.
          size_t currentFrame = 0;
-         for (size_t i = 0; i < eventCount; ++i) {
-                 size_t eventFrame = static_cast<size_t>(eventQueue[i].sampleOffset);
-                 if (eventFrame > static_cast<size_t>(data.numSamples))
-                         eventFrame = data.numSamples;
-
-                 size_t chunkSize = eventFrame - currentFrame;
-                 if (chunkSize > 0) {
-                         entropictronDsp->process(buffer, chunkSize);
-                         buffer[0] += chunkSize;
-                         buffer[1] += chunkSize;
-                         buffer[2] += chunkSize;
-                         buffer[3] += chunkSize;
-                         currentFrame += chunkSize;
+         while (!eventMerger.empty()) {
+                 auto cursor = eventMerger.top();
+                 size_t eventFrame = static_cast<size_t>(std::clamp(cursor.offset, 0, data.numSamples));
+                 if (eventFrame > currentFrame) {
+                         processChunk(eventFrame - currentFrame);
+                         currentFrame = eventFrame;
                  }
 
                  // Apply event at exact sample
-                 switch (eventQueue[i].type) {
-                 case QueuedEvent::Type::DspTimer:
-                         entropictronDsp->updateEntropy();
-                         break;
-                 case QueuedEvent::Type::NoteOn:
-                         if (entropictronDsp->playMode() == PlayMode::HoldMode)
-                                 entropictronDsp->pressKey(true);
-                         break;
-                 case QueuedEvent::Type::NoteOff:
-                         if (entropictronDsp->playMode() == PlayMode::HoldMode)
-                                 entropictronDsp->pressKey(false);
-                         break;
-                 case QueuedEvent::Type::Automation:
-                         updateParameters(static_cast<ParameterId>(eventQueue[i].automation.pid),
-                                          eventQueue[i].automation.value);
-                         dspStateUpdated = true;
-                         break;
+                 if (cursor.source == 0) {
+                         Event event{};
+                         if (midiEvents->getEvent(cursor.index, event) == kResultOk
+                             && entropictronDsp->playMode() == PlayMode::HoldMode)
+                                 entropictronDsp->pressKey(event.type == Event::kNoteOnEvent);
+                 } else {
+                         auto queue = inputParams->getParameterData(cursor.source - 1);
+                         int32 pointOffset = 0;
+                         ParamValue value = 0;
+                         if (queue->getPoint(cursor.index, pointOffset, value) == kResultOk) {
+                                 updateParameters(static_cast<ParameterId>(queue->getParameterId()), value);
+                                 dspStateUpdated = true;
+                                 if (sourceRamps[cursor.source])
+                                         steppedRampEvents.fetch_add(1, std::memory_order_relaxed);
+                         }
                  }
+                 nextEvent(cursor);
          }
 
          // Process remaining buffer after last event
-         if (currentFrame < static_cast<size_t>(data.numSamples)) {
-                 size_t remaining = data.numSamples - currentFrame;
-                 entropictronDsp->process(buffer, remaining);
-         }
+         if (currentFrame < static_cast<size_t>(data.numSamples))
+                 processChunk(data.numSamples - currentFrame);
 
          if (dspStateUpdated) {
                  entropictronDsp->getState(dspState);
@@ -369,6 +527,18 @@ void EntVstProcessor::initNoiseParamMappings()
         paramMap[ParameterId::Noise1ResonanceId] = [noise](ParamValue v) {
                 noise->setResonance(static_cast<float>(v));
         };
+        rampParamMap[ParameterId::Noise1DensityId] = {static_cast<int>(NoiseId::Noise1),
+                                                       ENT_PARAM_NOISE_DENSITY,
+                                                       [](double v) { return v; }};
+        rampParamMap[ParameterId::Noise1GainId] = {static_cast<int>(NoiseId::Noise1),
+                                                    ENT_PARAM_NOISE_GAIN,
+                                                    DspNoiseProxyVst::gainFromNormalized};
+        rampParamMap[ParameterId::Noise1CutOffId] = {static_cast<int>(NoiseId::Noise1),
+                                                      ENT_PARAM_NOISE_CUTOFF,
+                                                      DspNoiseProxyVst::cutoffFromNormalized};
+        rampParamMap[ParameterId::Noise1ResonanceId] = {static_cast<int>(NoiseId::Noise1),
+                                                         ENT_PARAM_NOISE_RESONANCE,
+                                                         [](double v) { return v; }};
 
         // Noise 2
         noise = entropictronDsp->getNoise(NoiseId::Noise2);
@@ -399,6 +569,18 @@ void EntVstProcessor::initNoiseParamMappings()
         paramMap[ParameterId::Noise2ResonanceId] = [noise](ParamValue v) {
                 noise->setResonance(static_cast<float>(v));
         };
+        rampParamMap[ParameterId::Noise2DensityId] = {static_cast<int>(NoiseId::Noise2),
+                                                       ENT_PARAM_NOISE_DENSITY,
+                                                       [](double v) { return v; }};
+        rampParamMap[ParameterId::Noise2GainId] = {static_cast<int>(NoiseId::Noise2),
+                                                    ENT_PARAM_NOISE_GAIN,
+                                                    DspNoiseProxyVst::gainFromNormalized};
+        rampParamMap[ParameterId::Noise2CutOffId] = {static_cast<int>(NoiseId::Noise2),
+                                                      ENT_PARAM_NOISE_CUTOFF,
+                                                      DspNoiseProxyVst::cutoffFromNormalized};
+        rampParamMap[ParameterId::Noise2ResonanceId] = {static_cast<int>(NoiseId::Noise2),
+                                                         ENT_PARAM_NOISE_RESONANCE,
+                                                         [](double v) { return v; }};
 }
 
 void EntVstProcessor::initCrackleParamMappings()
@@ -487,6 +669,15 @@ void EntVstProcessor::initGlitchParamMappings()
         paramMap[ParameterId::Glitch1WetId] = [glitch](ParamValue v) {
                 glitch->setWet(DspGlitchProxyVst::wetFromNormalized(v));
         };
+        paramMap[ParameterId::Glitch1CrossfadeId] = [glitch](ParamValue v) {
+                glitch->setCrossfade(DspGlitchProxyVst::crossfadeFromNormalized(v));
+        };
+        paramMap[ParameterId::Glitch1SpeedId] = [glitch](ParamValue v) {
+                glitch->setSpeed(DspGlitchProxyVst::speedFromNormalized(v));
+        };
+        paramMap[ParameterId::Glitch1InterpolationId] = [glitch](ParamValue v) {
+                glitch->setInterpolation(DspGlitchProxyVst::interpolationFromNormalized(v));
+        };
 
         // Glitch 2
         glitch = entropictronDsp->getGlitch(GlitchId::Glitch2);
@@ -514,6 +705,15 @@ void EntVstProcessor::initGlitchParamMappings()
         paramMap[ParameterId::Glitch2WetId] = [glitch](ParamValue v) {
                 glitch->setWet(DspGlitchProxyVst::wetFromNormalized(v));
         };
+        paramMap[ParameterId::Glitch2CrossfadeId] = [glitch](ParamValue v) {
+                glitch->setCrossfade(DspGlitchProxyVst::crossfadeFromNormalized(v));
+        };
+        paramMap[ParameterId::Glitch2SpeedId] = [glitch](ParamValue v) {
+                glitch->setSpeed(DspGlitchProxyVst::speedFromNormalized(v));
+        };
+        paramMap[ParameterId::Glitch2InterpolationId] = [glitch](ParamValue v) {
+                glitch->setInterpolation(DspGlitchProxyVst::interpolationFromNormalized(v));
+        };
 }
 
 void EntVstProcessor::initRgateParamMappings()
@@ -587,6 +787,13 @@ tresult EntVstProcessor::setState (IBStream *state)
         EntState entState{data};
         entState.getState(dspState);
 
+        // Allocate the glitch history before the audio thread needs it.
+        for (auto id : {GlitchId::Glitch1, GlitchId::Glitch2}) {
+                auto glitch = ent_state_get_glitch_const(dspState, static_cast<size_t>(id));
+                if (ent_state_glitch_get_enabled(glitch))
+                        allocateGlitchHistory();
+        }
+
         isPendingState.store(true, std::memory_order_release);
 
         return kResultOk;
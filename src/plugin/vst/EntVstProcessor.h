@@ -26,9 +26,14 @@
 
 #include "globals.h"
 #include "EntVstParameters.h"
+#include "EventMerger.h"
 
 #include "public.sdk/source/vst/vstaudioeffect.h"
 
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 #ifdef __cplusplus
 extern "C" {
 #endif // __cplusplus
@@ -48,15 +53,17 @@ using namespace EntVst;
 class DspWrapper;
 struct ent_state;
 
-constexpr int QUEUE_MAX_EVENTS = 512;
+// The event list and the queue of each parameter.
+constexpr size_t EVENT_MAX_SOURCES = 128;
+
+// Points of the ramped parameters per block passed to the DSP.
+constexpr size_t RAMP_MAX_EVENTS = 512;
 
-struct QueuedEvent {
-    int32 sampleOffset;
-        enum class Type { NoteOn, NoteOff, Automation, DspTimer } type;
-    union {
-        struct { int32 pitch; float velocity; bool on; } note;
-        struct { Steinberg::Vst::ParamID pid; Steinberg::Vst::ParamValue value; } automation;
-    };
+// A parameter ramped by the DSP inside the block.
+struct RampParam {
+        int module;
+        enum ent_param param;
+        double (*fromNormalized)(double value);
 };
 
 class EntVstProcessor : public AudioEffect {
@@ -73,6 +80,7 @@ class EntVstProcessor : public AudioEffect {
         tresult PLUGIN_API setupProcessing(ProcessSetup& setup) SMTG_OVERRIDE;
         tresult PLUGIN_API setActive(TBool state) SMTG_OVERRIDE;
         tresult PLUGIN_API process(ProcessData& data) SMTG_OVERRIDE;
+        tresult PLUGIN_API notify(IMessage* message) SMTG_OVERRIDE;
 
  protected:
         tresult PLUGIN_API setProcessing (TBool state) SMTG_OVERRIDE;
@@ -84,17 +92,40 @@ class EntVstProcessor : public AudioEffect {
         void initRgateParamMappings();
         void updateParameters(ParameterId pid, ParamValue value);
         void storeDspSate();
+        void allocateGlitchHistory();
+        void startService();
+        void stopService();
+        void runService();
         tresult setState (IBStream *state) SMTG_OVERRIDE;
         tresult getState (IBStream *state) SMTG_OVERRIDE;
 
  private:
         std::unordered_map<ParameterId, UpdateParamFunc> paramMap;
+        std::unordered_map<ParameterId, RampParam> rampParamMap;
         std::unique_ptr<DspWrapper> entropictronDsp;
         bool dspStateUpdated;
         std::atomic<bool> isPendingState;
         struct ent_state* dspState;
-        size_t eventCount;
-        std::array<QueuedEvent, QUEUE_MAX_EVENTS> eventQueue;
+        EventMerger<EVENT_MAX_SOURCES> eventMerger;
+        // The ramp parameter of each parameter queue source.
+        std::array<const RampParam*, EVENT_MAX_SOURCES> sourceRamps;
+        size_t rampEventCount;
+        std::array<struct ent_event, RAMP_MAX_EVENTS> rampEvents;
+        // Automation points dropped because the parameter queues didn't
+        // fit the merge, only their last points were applied.
+        std::atomic<size_t> droppedEvents;
+        // Points of the ramped parameters applied as steps because the
+        // ramp events were full.
+        std::atomic<size_t> steppedRampEvents;
+        // Serializes the history allocations of the main and service threads.
+        std::mutex glitchHistoryMutex;
+        // Set by process() when an enabled glitch has no history yet,
+        // the service thread allocates it while the processor is active.
+        std::atomic<bool> glitchHistoryRequested;
+        std::thread serviceThread;
+        std::mutex serviceMutex;
+        std::condition_variable serviceCondition;
+        bool isServiceStopped;
 };
 
 #endif // ENT_VST_PROCESSOR_H
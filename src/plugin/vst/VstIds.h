@@ -31,4 +31,7 @@
 using namespace Steinberg;
 static const FUID EntVstProcessorUID (0x4C4302E9, 0xDFE24902, 0xB3B49DE4, 0x9C179F91);
 static const FUID EntVstControllerUID(0x8A3844E3, 0xBAF94A6F, 0x9D544306, 0x5CA27CFE);
+
+// Sent by the controller to the processor when a glitch module is enabled.
+static constexpr FIDString EntVstGlitchHistoryMessageId = "GlitchHistory";
 #endif // ENT_VST_IDS_H
@@ -0,0 +1,748 @@
+/**
+ * File name: EntBench.cpp
+ * Project: Entropictron (A texture synthesizer)
+ *
+ * Copyright (C) 2026 Iurie Nistor
+ *
+ * This file is part of Entropictron.
+ *
+ * Entropictron is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "entropictron.h"
+#include "ent_noise.h"
+#include "ent_crackle.h"
+#include "ent_glitch.h"
+#include "ent_history.h"
+#include "ent_rgate.h"
+#include "ent_filter.h"
+#include "ent_shelf_filter.h"
+#include "EventMerger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define ENT_BENCH_HAS_TSC
+#endif
+
+namespace {
+
+// Process function of a benchmark case, called once per block.
+// The data holds the input, output and scratch channels.
+using ProcessFunc = std::function<void(float **data, size_t size)>;
+
+struct BenchCase {
+        std::string module;
+        std::string params;
+        // Creates the module and returns its process function.
+        std::function<ProcessFunc(unsigned int sampleRate, size_t blockSize)> create;
+        // Number of instances processed per block, the results are per instance.
+        size_t instances = 1;
+};
+
+struct BenchOptions {
+        std::vector<unsigned int> sampleRates = {44100, 48000, 96000, 192000};
+        std::vector<size_t> blockSizes = {16, 32, 64, 128, 256, 512, 1024, 2048, 4096};
+        std::string module;
+        unsigned int runs = 7;
+        double seconds = 0.25;
+        bool csv = false;
+        bool layout = false;
+};
+
+struct BenchResult {
+        double nsPerSample = 0.0;
+        double cyclesPerSample = 0.0;
+};
+
+uint64_t readCycles()
+{
+#ifdef ENT_BENCH_HAS_TSC
+        return __rdtsc();
+#else
+        return 0;
+#endif
+}
+
+double median(std::vector<double> values)
+{
+        std::sort(values.begin(), values.end());
+        auto n = values.size();
+        if (n % 2)
+                return values[n / 2];
+        return 0.5 * (values[n / 2 - 1] + values[n / 2]);
+}
+
+template<class T, class Deleter>
+std::shared_ptr<T> makeShared(T *obj, Deleter deleter)
+{
+        return std::shared_ptr<T>(obj, [deleter](T *p) { deleter(&p); });
+}
+
+ProcessFunc noiseCase(unsigned int sampleRate,
+                      enum ent_noise_type type,
+                      enum ent_filter_type filterType,
+                      bool stereo = true,
+                      float density = 1.0f)
+{
+        auto noise = makeShared(ent_noise_create(sampleRate), ent_noise_free);
+        ent_noise_set_type(noise.get(), type);
+        ent_noise_set_filter_type(noise.get(), filterType);
+        ent_noise_set_brightness(noise.get(), 0.5f);
+        ent_noise_set_stereo(noise.get(), stereo ? 0.5f : 0.0f);
+        ent_noise_set_density(noise.get(), density);
+        ent_noise_enable(noise.get(), true);
+        return [noise](float **data, size_t size) {
+                ent_noise_process(noise.get(), data + 2, size);
+        };
+}
+
+// Noise 1 and Noise 2 like in the synth, processed separately or as a bank.
+ProcessFunc noiseBankCase(unsigned int sampleRate,
+                          enum ent_filter_type filterType,
+                          bool bank)
+{
+        auto noise1 = makeShared(ent_noise_create(sampleRate), ent_noise_free);
+        auto noise2 = makeShared(ent_noise_create(sampleRate), ent_noise_free);
+        for (const auto &noise : {noise1, noise2}) {
+                ent_noise_set_filter_type(noise.get(), filterType);
+                ent_noise_set_brightness(noise.get(), 0.5f);
+                ent_noise_set_stereo(noise.get(), 0.5f);
+                ent_noise_enable(noise.get(), true);
+        }
+        ent_noise_set_type(noise2.get(), ENT_NOISE_TYPE_PINK);
+        return [noise1, noise2, bank](float **data, size_t size) {
+                if (bank) {
+                        struct ent_noise *noises[ENT_NOISE_BANK_SIZE] = {noise1.get(), noise2.get()};
+                        ent_noise_process_bank(noises, data + 2, size);
+                } else {
+                        ent_noise_process(noise1.get(), data + 2, size);
+                        ent_noise_process(noise2.get(), data + 2, size);
+                }
+        };
+}
+
+ProcessFunc crackleCase(unsigned int sampleRate,
+                        bool dense,
+                        enum ent_crackle_envelope shape = ENT_CRACKLE_ENV_EXPONENTIAL)
+{
+        auto crackle = makeShared(ent_crackle_create(sampleRate), ent_crackle_free);
+        ent_crackle_set_envelope_shape(crackle.get(), shape);
+        ent_crackle_set_rate(crackle.get(), dense ? 150.0f : 0.5f);
+        ent_crackle_set_duration(crackle.get(), dense ? 50.0f : 0.1f);
+        ent_crackle_set_stereo_spread(crackle.get(), 0.5f);
+        ent_crackle_enable(crackle.get(), true);
+        return [crackle](float **data, size_t size) {
+                ent_crackle_process(crackle.get(), data + 2, data + 4, size);
+        };
+}
+
+ProcessFunc crackleVoicesCase(unsigned int sampleRate, float rate, int voices)
+{
+        auto crackle = makeShared(ent_crackle_create(sampleRate), ent_crackle_free);
+        ent_crackle_set_rate(crackle.get(), rate);
+        ent_crackle_set_duration(crackle.get(), 50.0f);
+        ent_crackle_set_voices(crackle.get(), voices);
+        ent_crackle_set_stereo_spread(crackle.get(), 0.5f);
+        ent_crackle_enable(crackle.get(), true);
+        return [crackle](float **data, size_t size) {
+                ent_crackle_process(crackle.get(), data + 2, data + 4, size);
+        };
+}
+
+ProcessFunc glitchCase(unsigned int sampleRate,
+                       size_t blockSize,
+                       float speed = ENT_GLITCH_DEFAULT_SPEED,
+                       enum ent_glitch_interpolation interp = ENT_GLITCH_DEFAULT_INTERP)
+{
+        auto glitch = makeShared(ent_glitch_create(sampleRate), ent_glitch_free);
+        auto history = makeShared(ent_history_create(sampleRate,
+                                                     ENT_GLITCH_HISTORY_LENGTH,
+                                                     blockSize + ENT_GLITCH_HISTORY_TAPS),
+                                  ent_history_free);
+        ent_glitch_set_probability(glitch.get(), ENT_GLITCH_MAX_PROB);
+        ent_glitch_set_speed(glitch.get(), speed);
+        ent_glitch_set_interpolation(glitch.get(), interp);
+        ent_glitch_enable(glitch.get(), true);
+        return [glitch, history](float **data, size_t size) {
+                ent_history_write(history.get(), data, size);
+                ent_glitch_process(glitch.get(), history.get(), data, data + 2, size);
+        };
+}
+
+ProcessFunc rgateCase(unsigned int sampleRate, size_t)
+{
+        auto rgate = makeShared(ent_rgate_create(sampleRate), ent_rgate_free);
+        ent_rgate_enable(rgate.get(), true);
+        return [rgate](float **data, size_t size) {
+                ent_rgate_process(rgate.get(), data, data + 2, size);
+        };
+}
+
+ProcessFunc filterCase(unsigned int sampleRate,
+                       enum ent_filter_type type,
+                       bool modulated = false)
+{
+        auto filter = std::make_shared<struct ent_filter>();
+        ent_filter_init(filter.get(), sampleRate, 800.0f, 0.5f);
+        ent_filter_set_type(filter.get(), type);
+        if (!modulated) {
+                return [filter](float **data, size_t size) {
+                        ent_filter_process(filter.get(), data + 2, size);
+                };
+        }
+
+        // The cutoff and resonance change every block, like under entropy.
+        auto phase = std::make_shared<float>(0.0f);
+        return [filter, phase](float **data, size_t size) {
+                *phase += 0.01f;
+                if (*phase > 1.0f)
+                        *phase -= 1.0f;
+                ent_filter_set_cutoff(filter.get(), 200.0f + 8000.0f * *phase);
+                ent_filter_set_resonance(filter.get(), 0.25f + 0.5f * *phase);
+                ent_filter_process(filter.get(), data + 2, size);
+        };
+}
+
+ProcessFunc shelfFilterCase(unsigned int sampleRate, size_t)
+{
+        auto filter = std::make_shared<struct ent_shelf_filter>();
+        ent_shelf_filter_init(filter.get(), sampleRate, 4000.0f, 3.0f);
+        return [filter](float **data, size_t size) {
+                ent_shelf_filter_process(filter.get(), data[2], size);
+                ent_shelf_filter_process(filter.get(), data[3], size);
+        };
+}
+
+std::shared_ptr<struct entropictron> createEntropictron(unsigned int sampleRate,
+                                                       size_t blockSize)
+{
+        struct entropictron *dsp = nullptr;
+        ent_create(&dsp, sampleRate);
+        auto ent = makeShared(dsp, ent_free);
+        ent_set_max_block_size(dsp, blockSize);
+        for (int i = 0; i < 2; i++) {
+                ent_noise_enable(ent_get_noise(dsp, i), true);
+                ent_crackle_enable(ent_get_crackle(dsp, i), true);
+                ent_glitch_enable(ent_get_glitch(dsp, i), true);
+        }
+        ent_rgate_enable(ent_get_rgate(dsp), true);
+        ent_alloc_glitch_history(dsp);
+        ent_set_entropy_rate(dsp, 0.5f);
+        ent_set_play_mode(dsp, ENT_PLAY_MODE_ON);
+        return ent;
+}
+
+ProcessFunc entropictronCase(unsigned int sampleRate, size_t blockSize)
+{
+        auto ent = createEntropictron(sampleRate, blockSize);
+        return [ent](float **data, size_t size) {
+                ent_process(ent.get(), data, size);
+        };
+}
+
+// Offline rendering with the modules rendered by the worker threads,
+// only the blocks of at least the parallel threshold use them.
+ProcessFunc entropictronWorkersCase(unsigned int sampleRate, size_t blockSize)
+{
+        auto ent = createEntropictron(sampleRate, blockSize);
+        ent_set_offline(ent.get(), true);
+        ent_set_worker_threads(ent.get(), ENT_MAX_WORKER_THREADS);
+        return [ent](float **data, size_t size) {
+                ent_process(ent.get(), data, size);
+        };
+}
+
+// Dense automation of the noise cutoffs, a point every
+// automationPeriod frames, like a drawn curve in the host.
+constexpr size_t automationPeriod = 16;
+
+std::vector<struct ent_event> createAutomation(size_t blockSize)
+{
+        std::vector<struct ent_event> events;
+        for (size_t offset = automationPeriod; offset <= blockSize; offset += automationPeriod) {
+                float cutoff = (offset / automationPeriod) % 2 ? 4000.0f : 1000.0f;
+                for (int i = 0; i < 2; i++)
+                        events.push_back({offset, ENT_PARAM_NOISE_CUTOFF, i, cutoff});
+        }
+        return events;
+}
+
+// The automation points are ramped by the DSP inside the block.
+ProcessFunc entropictronRampsCase(unsigned int sampleRate, size_t blockSize)
+{
+        auto ent = createEntropictron(sampleRate, blockSize);
+        return [ent, events = createAutomation(blockSize)](float **data, size_t size) {
+                ent_process_events(ent.get(), data, size, events.data(), events.size());
+        };
+}
+
+// The block is split at the automation points and the values are set
+// between the ent_process() calls.
+ProcessFunc entropictronSplitCase(unsigned int sampleRate, size_t blockSize)
+{
+        auto ent = createEntropictron(sampleRate, blockSize);
+        return [ent, events = createAutomation(blockSize)](float **data, size_t size) {
+                size_t frame = 0;
+                for (const auto &event : events) {
+                        if (event.offset > frame) {
+                                float *chunk[4] = {data[0] + frame, data[1] + frame,
+                                                   data[2] + frame, data[3] + frame};
+                                ent_process(ent.get(), chunk, event.offset - frame);
+                                frame = event.offset;
+                        }
+                        ent_noise_set_cutoff(ent_get_noise(ent.get(), event.module), event.value);
+                }
+                if (frame < size) {
+                        float *chunk[4] = {data[0] + frame, data[1] + frame,
+                                           data[2] + frame, data[3] + frame};
+                        ent_process(ent.get(), chunk, size - frame);
+                }
+        };
+}
+
+// Many instances, like in a large session, where the instance state
+// doesn't fit the caches.
+ProcessFunc entropictronInstancesCase(unsigned int sampleRate,
+                                      size_t blockSize,
+                                      size_t instances)
+{
+        std::vector<std::shared_ptr<struct entropictron>> ents;
+        for (size_t i = 0; i < instances; i++)
+                ents.push_back(createEntropictron(sampleRate, blockSize));
+        return [ents](float **data, size_t size) {
+                for (const auto &ent : ents)
+                        ent_process(ent.get(), data, size);
+        };
+}
+
+// Automation points of many parameter queues, each sorted by offset,
+// like a host sending thousands of points per block. The merge case
+// takes them in offset order with the event merge of the plugin
+// processor, the sort case copies and sorts them per block.
+constexpr size_t maxMergeSources = 128;
+
+struct AutomationPoint {
+        int32_t offset;
+        float value;
+};
+
+std::vector<std::vector<AutomationPoint>> createQueues(size_t blockSize,
+                                                       size_t queues,
+                                                       size_t points)
+{
+        std::mt19937 gen(1);
+        std::uniform_int_distribution<int32_t> dist(0, static_cast<int32_t>(blockSize) - 1);
+        std::vector<std::vector<AutomationPoint>> sources(queues);
+        for (auto &queue : sources) {
+                for (size_t i = 0; i < points; i++)
+                        queue.push_back({dist(gen), static_cast<float>(i) / points});
+                std::sort(queue.begin(), queue.end(), [](const auto &a, const auto &b) {
+                        return a.offset < b.offset;
+                });
+        }
+        return sources;
+}
+
+ProcessFunc eventMergeCase(size_t blockSize, size_t queues, size_t points)
+{
+        auto merger = std::make_shared<EventMerger<maxMergeSources>>();
+        return [merger, sources = createQueues(blockSize, queues, points)](float **data, size_t) {
+                merger->clear();
+                for (size_t i = 0; i < sources.size(); i++)
+                        merger->push(i, 0, sources[i][0].offset);
+                while (!merger->empty()) {
+                        auto cursor = merger->top();
+                        const auto &queue = sources[cursor.source];
+                        data[2][cursor.offset] += queue[cursor.index].value;
+                        size_t next = cursor.index + 1;
+                        if (next < queue.size())
+                                merger->next(next, queue[next].offset);
+                        else
+                                merger->pop();
+                }
+        };
+}
+
+ProcessFunc eventSortCase(size_t blockSize, size_t queues, size_t points)
+{
+        auto events = std::make_shared<std::vector<AutomationPoint>>(queues * points);
+        return [events, sources = createQueues(blockSize, queues, points)](float **data, size_t) {
+                size_t count = 0;
+                for (const auto &queue : sources) {
+                        for (const auto &point : queue)
+                                (*events)[count++] = point;
+                }
+                std::sort(events->begin(), events->begin() + count, [](const auto &a, const auto &b) {
+                        return a.offset < b.offset;
+                });
+                for (size_t i = 0; i < count; i++)
+                        data[2][(*events)[i].offset] += (*events)[i].value;
+        };
+}
+
+std::vector<BenchCase> createCases()
+{
+        const std::pair<enum ent_noise_type, const char*> noiseTypes[] = {
+                {ENT_NOISE_TYPE_WHITE, "white"},
+                {ENT_NOISE_TYPE_PINK, "pink"},
+                {ENT_NOISE_TYPE_BROWN, "brown"}
+        };
+        const std::pair<enum ent_filter_type, const char*> filterTypes[] = {
+                {ENT_FILTER_TYPE_ALLPASS, "allpass"},
+                {ENT_FILTER_TYPE_LOWPASS, "lowpass"},
+                {ENT_FILTER_TYPE_BANDPASS, "bandpass"},
+                {ENT_FILTER_TYPE_HIGHPASS, "highpass"}
+        };
+
+        std::vector<BenchCase> cases;
+        for (const auto &[type, typeName] : noiseTypes) {
+                for (const auto &[filterType, filterName] : filterTypes) {
+                        cases.push_back({"noise",
+                                         std::string(typeName) + "/" + filterName,
+                                         [type, filterType](unsigned int sr, size_t) {
+                                                 return noiseCase(sr, type, filterType);
+                                         }});
+                }
+        }
+
+        // Noise without stereo spread.
+        for (const auto &[filterType, filterName] : filterTypes) {
+                cases.push_back({"noise",
+                                 std::string("white/") + filterName + "/mono",
+                                 [filterType](unsigned int sr, size_t) {
+                                         return noiseCase(sr, ENT_NOISE_TYPE_WHITE, filterType, false);
+                                 }});
+        }
+
+        // Low density "dust" noise.
+        for (const auto &[filterType, filterName] : filterTypes) {
+                cases.push_back({"noise",
+                                 std::string("white/") + filterName + "/sparse",
+                                 [filterType](unsigned int sr, size_t) {
+                                         return noiseCase(sr, ENT_NOISE_TYPE_WHITE, filterType, true, 0.02f);
+                                 }});
+        }
+        for (const auto &[filterType, filterName] : filterTypes) {
+                for (bool bank : {false, true}) {
+                        cases.push_back({"noise",
+                                         std::string(bank ? "bank/" : "separate/") + filterName,
+                                         [filterType, bank](unsigned int sr, size_t) {
+                                                 return noiseBankCase(sr, filterType, bank);
+                                         }});
+                }
+        }
+
+        cases.push_back({"crackle", "dense", [](unsigned int sr, size_t) {
+                return crackleCase(sr, true);
+        }});
+        cases.push_back({"crackle", "dense/linear", [](unsigned int sr, size_t) {
+                return crackleCase(sr, true, ENT_CRACKLE_ENV_LINEAR);
+        }});
+        cases.push_back({"crackle", "dense/triangle", [](unsigned int sr, size_t) {
+                return crackleCase(sr, true, ENT_CRACKLE_ENV_TRIANGLE);
+        }});
+        cases.push_back({"crackle", "sparse", [](unsigned int sr, size_t) {
+                return crackleCase(sr, false);
+        }});
+
+        // Overlapping 50 ms bursts, cost versus density.
+        for (auto rate : {1, 10, 50, 150}) {
+                cases.push_back({"crackle",
+                                 "voices16/rate" + std::to_string(rate),
+                                 [rate](unsigned int sr, size_t) {
+                                         return crackleVoicesCase(sr, rate, ENT_CRACKLE_MAX_VOICES);
+                                 }});
+        }
+        cases.push_back({"glitch", "default", [](unsigned int sr, size_t bs) {
+                return glitchCase(sr, bs);
+        }});
+
+        // Pitched and reversed repeats.
+        for (auto [speed, speedName] : {std::pair{0.5f, "0.5"},
+                                        std::pair{1.5f, "1.5"},
+                                        std::pair{-1.0f, "-1"}}) {
+                for (auto [interp, interpName] : {std::pair{ENT_GLITCH_INTERP_LINEAR, "linear"},
+                                                  std::pair{ENT_GLITCH_INTERP_HERMITE, "hermite"}}) {
+                        cases.push_back({"glitch",
+                                         std::string("speed") + speedName + "/" + interpName,
+                                         [speed, interp](unsigned int sr, size_t bs) {
+                                                 return glitchCase(sr, bs, speed, interp);
+                                         }});
+                }
+        }
+        cases.push_back({"rgate", "default", rgateCase});
+
+        for (const auto &[filterType, filterName] : filterTypes) {
+                cases.push_back({"filter", filterName, [filterType](unsigned int sr, size_t) {
+                        return filterCase(sr, filterType);
+                }});
+        }
+        cases.push_back({"filter", "lowpass/modulated", [](unsigned int sr, size_t) {
+                return filterCase(sr, ENT_FILTER_TYPE_LOWPASS, true);
+        }});
+
+        cases.push_back({"shelf_filter", "default", shelfFilterCase});
+        cases.push_back({"entropictron", "all_enabled", entropictronCase});
+        cases.push_back({"entropictron", "offline_workers", entropictronWorkersCase});
+        cases.push_back({"entropictron", "automation/ramps", entropictronRampsCase});
+        cases.push_back({"entropictron", "automation/split", entropictronSplitCase});
+        cases.push_back({"entropictron", "all_enabled_x128", [](unsigned int sr, size_t bs) {
+                return entropictronInstancesCase(sr, bs, 128);
+        }, 128});
+
+        const std::pair<size_t, size_t> mergeSizes[] = {{8, 512}, {64, 64}, {64, 256}};
+        for (const auto &[queues, points] : mergeSizes) {
+                auto params = std::to_string(queues) + "x" + std::to_string(points);
+                cases.push_back({"event_merge", "merge/" + params, [queues, points](unsigned int, size_t bs) {
+                        return eventMergeCase(bs, queues, points);
+                }});
+                cases.push_back({"event_merge", "sort/" + params, [queues, points](unsigned int, size_t bs) {
+                        return eventSortCase(bs, queues, points);
+                }});
+        }
+
+        return cases;
+}
+
+BenchResult runCase(const BenchCase &benchCase,
+                    unsigned int sampleRate,
+                    size_t blockSize,
+                    const BenchOptions &options)
+{
+        std::vector<float> input[2];
+        std::vector<float> output[2];
+        std::vector<float> scratch[2];
+        std::mt19937 gen(1);
+        std::uniform_real_distribution<float> dist(-0.5f, 0.5f);
+        for (auto &buffer : input) {
+                buffer.resize(blockSize);
+                std::generate(buffer.begin(), buffer.end(), [&]() { return dist(gen); });
+        }
+        for (auto &buffer : output)
+                buffer.resize(blockSize);
+        for (auto &buffer : scratch)
+                buffer.resize(blockSize);
+
+        float *data[6] = {input[0].data(), input[1].data(),
+                          output[0].data(), output[1].data(),
+                          scratch[0].data(), scratch[1].data()};
+
+        auto process = benchCase.create(sampleRate, blockSize);
+        auto blocks = std::max(static_cast<size_t>(1),
+                               static_cast<size_t>(options.seconds * sampleRate) / blockSize);
+        auto runBlocks = [&]() {
+                for (size_t i = 0; i < blocks; i++) {
+                        std::memset(data[2], 0, blockSize * sizeof(float));
+                        std::memset(data[3], 0, blockSize * sizeof(float));
+                        process(data, blockSize);
+                }
+        };
+
+        // Warm-up the caches, branch predictors and the module state.
+        runBlocks();
+
+        std::vector<double> nsPerSample;
+        std::vector<double> cyclesPerSample;
+        const auto samples = static_cast<double>(blocks * blockSize * benchCase.instances);
+        for (unsigned int run = 0; run < options.runs; run++) {
+                auto cycles = readCycles();
+                auto start = std::chrono::steady_clock::now();
+                runBlocks();
+                auto end = std::chrono::steady_clock::now();
+                cycles = readCycles() - cycles;
+
+                std::chrono::duration<double, std::nano> ns = end - start;
+                nsPerSample.push_back(ns.count() / samples);
+                cyclesPerSample.push_back(cycles / samples);
+        }
+
+        return {median(nsPerSample), median(cyclesPerSample)};
+}
+
+void printUsage(const char *name)
+{
+        std::cout << "Usage: " << name << " [options]\n"
+                  << "Benchmark the Entropictron DSP modules.\n\n"
+                  << "Options:\n"
+                  << "  -m, --module <name>       run only the given module (noise, crackle,"
+                  << " glitch,\n"
+                  << "                            rgate, filter, shelf_filter, entropictron,\n"
+                  << "                            event_merge)\n"
+                  << "  -r, --sample-rate <rate>  run only the given sample rate\n"
+                  << "  -b, --block-size <size>   run only the given block size\n"
+                  << "  -n, --runs <number>       measured runs, median is reported"
+                  << " (default 7)\n"
+                  << "  -s, --seconds <seconds>   audio time per run (default 0.25)\n"
+                  << "  -c, --csv                 print results as CSV\n"
+                  << "  -l, --layout              print the memory layout of an instance\n"
+                  << "  -h, --help                show this help\n";
+}
+
+bool parseOptions(int argc, char *argv[], BenchOptions &options)
+{
+        try {
+                for (int i = 1; i < argc; i++) {
+                        std::string arg = argv[i];
+                        auto isOption = [&arg](const char *shortName, const char *longName) {
+                                return arg == shortName || arg == longName;
+                        };
+
+                        if (isOption("-h", "--help"))
+                                return false;
+
+                        if (isOption("-c", "--csv")) {
+                                options.csv = true;
+                                continue;
+                        }
+
+                        if (isOption("-l", "--layout")) {
+                                options.layout = true;
+                                continue;
+                        }
+
+                        if (i + 1 >= argc) {
+                                std::cerr << "missing value for " << arg << "\n";
+                                return false;
+                        }
+
+                        std::string value = argv[++i];
+                        if (isOption("-m", "--module")) {
+                                options.module = value;
+                        } else if (isOption("-r", "--sample-rate")) {
+                                options.sampleRates = {static_cast<unsigned int>(std::stoul(value))};
+                        } else if (isOption("-b", "--block-size")) {
+                                options.blockSizes = {std::stoul(value)};
+                        } else if (isOption("-n", "--runs")) {
+                                options.runs = std::stoul(value);
+                        } else if (isOption("-s", "--seconds")) {
+                                options.seconds = std::stod(value);
+                        } else {
+                                std::cerr << "unknown option " << arg << "\n";
+                                return false;
+                        }
+                }
+        } catch (const std::exception &) {
+                std::cerr << "invalid option value\n";
+                return false;
+        }
+
+        for (auto blockSize : options.blockSizes) {
+                if (blockSize < 1) {
+                        std::cerr << "invalid block size " << blockSize << "\n";
+                        return false;
+                }
+        }
+
+        if (options.runs < 1 || options.seconds <= 0.0) {
+                std::cerr << "invalid number of runs or duration\n";
+                return false;
+        }
+
+        return true;
+}
+
+void printMemoryLayout()
+{
+        auto ent = createEntropictron(ENT_DEFAULT_SAMPLE_RATE, ENT_DEFAULT_MAX_BLOCK_SIZE);
+        struct ent_memory_layout_entry entries[ENT_MEMORY_LAYOUT_MAX_ENTRIES];
+        auto n = ent_get_memory_layout(ent.get(), entries, ENT_MEMORY_LAYOUT_MAX_ENTRIES);
+        std::cout << std::left << std::setw(20) << "part"
+                  << std::right << std::setw(10) << "offset"
+                  << std::setw(10) << "size" << "\n";
+        for (size_t i = 0; i < n; i++) {
+                std::cout << std::left << std::setw(20) << entries[i].name
+                          << std::right << std::setw(10) << entries[i].offset
+                          << std::setw(10) << entries[i].size << "\n";
+        }
+        std::cout << "total DSP memory: " << ent_get_memory_size(ent.get())
+                  << " bytes (including the glitch history)\n";
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+        BenchOptions options;
+        if (!parseOptions(argc, argv, options)) {
+                printUsage(argv[0]);
+                return 1;
+        }
+
+        if (options.layout) {
+                printMemoryLayout();
+                return 0;
+        }
+
+        if (options.csv) {
+                std::cout << "module,params,sample_rate,block_size,ns_per_sample,"
+                          << "cycles_per_sample\n";
+        } else {
+                std::cout << std::left << std::setw(14) << "module"
+                          << std::setw(18) << "params"
+                          << std::right << std::setw(8) << "rate"
+                          << std::setw(7) << "block"
+                          << std::setw(12) << "ns/sample"
+                          << std::setw(14) << "cycles/sample" << "\n";
+        }
+
+        bool found = false;
+        for (const auto &benchCase : createCases()) {
+                if (!options.module.empty() && benchCase.module != options.module)
+                        continue;
+
+                found = true;
+                for (auto sampleRate : options.sampleRates) {
+                        for (auto blockSize : options.blockSizes) {
+                                auto res = runCase(benchCase, sampleRate, blockSize, options);
+                                if (options.csv) {
+                                        std::cout << benchCase.module << ","
+                                                  << benchCase.params << ","
+                                                  << sampleRate << ","
+                                                  << blockSize << ","
+                                                  << res.nsPerSample << ","
+                                                  << res.cyclesPerSample << "\n";
+                                } else {
+                                        std::cout << std::left << std::setw(14) << benchCase.module
+                                                  << std::setw(18) << benchCase.params
+                                                  << std::right << std::setw(8) << sampleRate
+                                                  << std::setw(7) << blockSize
+                                                  << std::fixed << std::setprecision(2)
+                                                  << std::setw(12) << res.nsPerSample
+                                                  << std::setw(14) << res.cyclesPerSample
+                                                  << "\n";
+                                }
+                        }
+                }
+        }
+
+        if (!found) {
+                std::cerr << "unknown module " << options.module << "\n";
+                return 1;
+        }
+
+        return 0;
+}
@@ -0,0 +1,234 @@
+/**
+ * File name: EntRender.cpp
+ * Project: Entropictron (A texture synthesizer)
+ *
+ * Copyright (C) 2026 Iurie Nistor
+ *
+ * This file is part of Entropictron.
+ *
+ * Entropictron is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "EntRenderer.h"
+#include "entropictron.h"
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct RenderOptions {
+        EntRenderer::Settings settings;
+        std::filesystem::path output;
+        unsigned int jobs = 0;
+        std::vector<std::filesystem::path> inputs;
+};
+
+void printUsage(const char *name)
+{
+        std::cout << "Usage: " << name << " [options] <preset> [<preset> ...]\n"
+                  << "Render Entropictron presets (.entp, .vstpreset or VST state)"
+                  << " offline.\n\n"
+                  << "Options:\n"
+                  << "  -o, --output <path>       output file, or directory for multiple"
+                  << " presets\n"
+                  << "  -d, --duration <seconds>  render duration (default 10)\n"
+                  << "  -r, --sample-rate <rate>  sample rate (default 48000)\n"
+                  << "  -b, --block-size <size>   process block size (default 512)\n"
+                  << "  -f, --format <wav|raw>    output format (default wav)\n"
+                  << "  -j, --jobs <number>       parallel jobs, 0 for all CPUs"
+                  << " (default 0)\n"
+                  << "  -t, --dsp-threads <number> worker threads per job rendering"
+                  << " the modules\n"
+                  << "                            of blocks of at least "
+                  << ENT_DEFAULT_PARALLEL_THRESHOLD << " frames (default 0)\n"
+                  << "  -h, --help                show this help\n";
+}
+
+bool parseOptions(int argc, char *argv[], RenderOptions &options)
+{
+        try {
+                for (int i = 1; i < argc; i++) {
+                        std::string arg = argv[i];
+                        auto isOption = [&arg](const char *shortName, const char *longName) {
+                                return arg == shortName || arg == longName;
+                        };
+
+                        if (isOption("-h", "--help")) {
+                                return false;
+                        } else if (!arg.empty() && arg[0] == '-') {
+                                if (i + 1 >= argc) {
+                                        std::cerr << "missing value for " << arg << "\n";
+                                        return false;
+                                }
+
+                                std::string value = argv[++i];
+                                if (isOption("-o", "--output")) {
+                                        options.output = value;
+                                } else if (isOption("-d", "--duration")) {
+                                        options.settings.duration = std::stod(value);
+                                } else if (isOption("-r", "--sample-rate")) {
+                                        options.settings.sampleRate = std::stoul(value);
+                                } else if (isOption("-b", "--block-size")) {
+                                        options.settings.blockSize = std::stoul(value);
+                                } else if (isOption("-j", "--jobs")) {
+                                        options.jobs = std::stoul(value);
+                                } else if (isOption("-t", "--dsp-threads")) {
+                                        options.settings.dspThreads = std::stoul(value);
+                                } else if (isOption("-f", "--format")) {
+                                        if (value == "wav") {
+                                                options.settings.format = WavWriter::Format::Wav;
+                                        } else if (value == "raw") {
+                                                options.settings.format = WavWriter::Format::Raw;
+                                        } else {
+                                                std::cerr << "unknown format " << value << "\n";
+                                                return false;
+                                        }
+                                } else {
+                                        std::cerr << "unknown option " << arg << "\n";
+                                        return false;
+                                }
+                        } else {
+                                options.inputs.emplace_back(arg);
+                        }
+                }
+        } catch (const std::exception &) {
+                std::cerr << "invalid option value\n";
+                return false;
+        }
+
+        if (options.inputs.empty()) {
+                std::cerr << "no input presets\n";
+                return false;
+        }
+
+        if (options.settings.sampleRate < 1 || options.settings.duration <= 0.0) {
+                std::cerr << "invalid sample rate or duration\n";
+                return false;
+        }
+
+        return true;
+}
+
+std::filesystem::path outputPath(const RenderOptions &options,
+                                 const std::filesystem::path &input)
+{
+        auto extension = options.settings.format == WavWriter::Format::Wav ? ".wav" : ".raw";
+        auto fileName = input.stem().string() + extension;
+
+        // A single input can be rendered directly to the given file.
+        if (options.inputs.size() == 1 && !options.output.empty()
+            && !std::filesystem::is_directory(options.output))
+                return options.output;
+
+        if (options.output.empty())
+                return input.parent_path() / fileName;
+
+        return options.output / fileName;
+}
+
+/**
+ * Returns the output of each input, or false if two inputs render to the
+ * same file, like the presets with the same name from different
+ * directories. The parallel jobs would write the file at the same time.
+ */
+bool outputPaths(const RenderOptions &options, std::vector<std::filesystem::path> &outputs)
+{
+        std::map<std::filesystem::path, std::filesystem::path> inputOfOutput;
+        for (const auto &input : options.inputs) {
+                auto output = outputPath(options, input);
+                std::error_code ec;
+                auto path = std::filesystem::weakly_canonical(output, ec);
+                if (ec)
+                        path = std::filesystem::absolute(output).lexically_normal();
+
+                auto res = inputOfOutput.emplace(path, input);
+                if (!res.second) {
+                        std::cerr << "error: " << res.first->second.string() << " and "
+                                  << input.string() << " render to the same file "
+                                  << output.string() << "\n";
+                        return false;
+                }
+                outputs.push_back(output);
+        }
+
+        return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+        RenderOptions options;
+        if (!parseOptions(argc, argv, options)) {
+                printUsage(argv[0]);
+                return 1;
+        }
+
+        if (options.inputs.size() > 1 && !options.output.empty()) {
+                std::error_code ec;
+                std::filesystem::create_directories(options.output, ec);
+                if (ec) {
+                        std::cerr << "can't create output directory "
+                                  << options.output << "\n";
+                        return 1;
+                }
+        }
+
+        std::vector<std::filesystem::path> outputs;
+        if (!outputPaths(options, outputs))
+                return 1;
+
+        auto jobs = options.jobs;
+        if (jobs == 0)
+                jobs = std::max(1u, std::thread::hardware_concurrency());
+        jobs = std::min(jobs, static_cast<unsigned int>(options.inputs.size()));
+
+        // Each worker owns its renderer and takes the next preset from the queue.
+        std::atomic<size_t> nextJob{0};
+        std::atomic<size_t> failedJobs{0};
+        std::mutex logMutex;
+        auto worker = [&]() {
+                EntRenderer renderer(options.settings);
+                for (auto i = nextJob.fetch_add(1); i < options.inputs.size();
+                     i = nextJob.fetch_add(1)) {
+                        const auto &input = options.inputs[i];
+                        const auto &output = outputs[i];
+                        auto res = renderer.render(input, output);
+                        std::lock_guard<std::mutex> lock(logMutex);
+                        if (res) {
+                                std::cout << input.string() << " -> " << output.string() << "\n";
+                        } else {
+                                std::cerr << "error: " << renderer.getError() << "\n";
+                                failedJobs++;
+                        }
+                }
+        };
+
+        std::vector<std::thread> threads;
+        for (unsigned int i = 1; i < jobs; i++)
+                threads.emplace_back(worker);
+        worker();
+        for (auto &thread : threads)
+                thread.join();
+
+        return failedJobs > 0 ? 1 : 0;
+}
@@ -0,0 +1,210 @@
+/**
+ * File name: EntRenderer.cpp
+ * Project: Entropictron (A texture synthesizer)
+ *
+ * Copyright (C) 2026 Iurie Nistor
+ *
+ * This file is part of Entropictron.
+ *
+ * Entropictron is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "EntRenderer.h"
+#include "EntState.h"
+#include "entropictron.h"
+#include "ent_state.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+
+namespace {
+
+struct EntDeleter {
+        void operator()(struct entropictron *ent) const
+        {
+                ent_free(&ent);
+        }
+};
+
+struct EntStateDeleter {
+        void operator()(struct ent_state *state) const
+        {
+                ent_state_free(state);
+        }
+};
+
+uint64_t readLe(const std::string &data, size_t pos, size_t bytes)
+{
+        const auto *p = reinterpret_cast<const unsigned char*>(data.data() + pos);
+        uint64_t val = 0;
+        for (size_t i = bytes; i > 0; i--)
+                val = (val << 8) | p[i - 1];
+        return val;
+}
+
+} // namespace
+
+EntRenderer::EntRenderer(const Settings &settings)
+        : renderSettings{settings}
+{
+        renderSettings.blockSize = std::max(renderSettings.blockSize,
+                                            static_cast<size_t>(1));
+        inputBuffer.assign(renderSettings.blockSize, 0.0f);
+        leftBuffer.resize(renderSettings.blockSize);
+        rightBuffer.resize(renderSettings.blockSize);
+}
+
+bool EntRenderer::render(const std::filesystem::path &input,
+                         const std::filesystem::path &output)
+{
+        errorMessage.clear();
+
+        EntState entState;
+        if (!loadState(input, entState)) {
+                errorMessage = "can't load state from " + input.string();
+                return false;
+        }
+
+        struct entropictron *dsp = nullptr;
+        if (ent_create(&dsp, renderSettings.sampleRate) != ENT_OK) {
+                errorMessage = "can't create DSP";
+                return false;
+        }
+        std::unique_ptr<struct entropictron, EntDeleter> ent(dsp);
+        if (ent_set_max_block_size(ent.get(), renderSettings.blockSize) != ENT_OK) {
+                errorMessage = "can't set DSP block size";
+                return false;
+        }
+
+        ent_set_offline(ent.get(), true);
+        if (ent_set_worker_threads(ent.get(), renderSettings.dspThreads) != ENT_OK) {
+                errorMessage = "can't create DSP worker threads";
+                return false;
+        }
+
+        std::unique_ptr<struct ent_state, EntStateDeleter> state(ent_state_create());
+        if (!state) {
+                errorMessage = "can't create DSP state";
+                return false;
+        }
+        entState.getState(state.get());
+        ent_set_state(ent.get(), state.get());
+        if (ent_is_glitch_history_needed(ent.get())
+            && ent_alloc_glitch_history(ent.get()) != ENT_OK) {
+                errorMessage = "can't allocate glitch history";
+                return false;
+        }
+
+        // Setting the state resets the playing flag, press the key after.
+        ent_press_key(ent.get(), true, ENT_DEFALUT_MIDI_KEY, ENT_MAX_KEY_VELOCITY);
+
+        WavWriter writer(renderSettings.format, renderSettings.sampleRate);
+        if (!writer.open(output)) {
+                errorMessage = "can't open output file " + output.string();
+                return false;
+        }
+
+        auto framesLeft = static_cast<size_t>(renderSettings.duration
+                                              * renderSettings.sampleRate);
+        while (framesLeft > 0) {
+                auto blockSize = std::min(framesLeft, renderSettings.blockSize);
+                std::fill_n(leftBuffer.begin(), blockSize, 0.0f);
+                std::fill_n(rightBuffer.begin(), blockSize, 0.0f);
+
+                float* data[4] = {inputBuffer.data(),
+                                  inputBuffer.data(),
+                                  leftBuffer.data(),
+                                  rightBuffer.data()};
+                ent_process(ent.get(), data, blockSize);
+
+                if (!writer.write(leftBuffer.data(), rightBuffer.data(), blockSize)) {
+                        errorMessage = "error on writing to " + output.string();
+                        return false;
+                }
+                framesLeft -= blockSize;
+        }
+
+        if (!writer.close()) {
+                errorMessage = "error on closing " + output.string();
+                return false;
+        }
+
+        return true;
+}
+
+const std::string& EntRenderer::getError() const
+{
+        return errorMessage;
+}
+
+bool EntRenderer::loadState(const std::filesystem::path &path, EntState &state)
+{
+        std::ifstream ifs(path, std::ios::binary);
+        if (!ifs.is_open())
+                return false;
+
+        std::string data((std::istreambuf_iterator<char>(ifs)),
+                         std::istreambuf_iterator<char>());
+
+        // VST3 preset file, the component state is the JSON state.
+        if (data.compare(0, 4, "VST3") == 0) {
+                std::string chunk;
+                if (!readVstPresetChunk(data, chunk))
+                        return false;
+                return state.fromJson(chunk);
+        }
+
+        // Entropictron preset (.entp) or raw VST state blob.
+        return state.fromJson(data);
+}
+
+bool EntRenderer::readVstPresetChunk(const std::string &data, std::string &chunk)
+{
+        // Header: "VST3", version (4), class ID (32), chunk list offset (8).
+        constexpr size_t headerSize = 48;
+        constexpr size_t listOffsetPos = 40;
+        constexpr size_t entrySize = 20;
+
+        if (data.size() < headerSize)
+                return false;
+
+        auto listOffset = readLe(data, listOffsetPos, 8);
+        // The offsets are read from the file, compared so they can't wrap.
+        if (listOffset > data.size() - 8 || data.compare(listOffset, 4, "List") != 0)
+                return false;
+
+        auto entryCount = readLe(data, listOffset + 4, 4);
+        for (uint64_t i = 0; i < entryCount; i++) {
+                auto pos = listOffset + 8 + i * entrySize;
+                if (pos > data.size() - entrySize)
+                        return false;
+
+                if (data.compare(pos, 4, "Comp") != 0)
+                        continue;
+
+                auto offset = readLe(data, pos + 4, 8);
+                auto size = readLe(data, pos + 12, 8);
+                if (offset > data.size() || size > data.size() - offset)
+                        return false;
+
+                chunk = data.substr(offset, size);
+                return true;
+        }
+
+        return false;
+}
@@ -0,0 +1,68 @@
+/**
+ * File name: EntRenderer.h
+ * Project: Entropictron (A texture synthesizer)
+ *
+ * Copyright (C) 2026 Iurie Nistor
+ *
+ * This file is part of Entropictron.
+ *
+ * Entropictron is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef ENT_RENDERER_H
+#define ENT_RENDERER_H
+
+#include "WavWriter.h"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+class EntState;
+
+/**
+ * Renders a preset offline, as fast as the CPU allows,
+ * using a dedicated entropictron DSP instance per render.
+ */
+class EntRenderer {
+ public:
+        struct Settings {
+                unsigned int sampleRate = 48000;
+                double duration = 10.0;
+                size_t blockSize = 512;
+                // Worker threads rendering the modules of a block.
+                size_t dspThreads = 0;
+                WavWriter::Format format = WavWriter::Format::Wav;
+        };
+
+        explicit EntRenderer(const Settings &settings);
+        bool render(const std::filesystem::path &input,
+                    const std::filesystem::path &output);
+        const std::string& getError() const;
+
+        static bool loadState(const std::filesystem::path &path, EntState &state);
+
+ protected:
+        static bool readVstPresetChunk(const std::string &data, std::string &chunk);
+
+ private:
+        Settings renderSettings;
+        std::vector<float> inputBuffer;
+        std::vector<float> leftBuffer;
+        std::vector<float> rightBuffer;
+        std::string errorMessage;
+};
+
+#endif // ENT_RENDERER_H
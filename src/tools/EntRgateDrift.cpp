@@ -0,0 +1,270 @@
+/**
+ * File name: EntRgateDrift.cpp
+ * Project: Entropictron (A texture synthesizer)
+ *
+ * Copyright (C) 2026 Iurie Nistor
+ *
+ * This file is part of Entropictron.
+ *
+ * Entropictron is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "ent_rgate.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+// The gate is closed and opened at fixed times, the only values
+// where the minimum and the maximum of the ranges can be equal.
+constexpr uint64_t GATE_INTERVAL_MS = 100;
+constexpr uint64_t GATE_DURATION_MS = 100;
+
+// The blocks have random sizes up to this size, the events must
+// not depend on where the blocks are split.
+constexpr size_t MAX_BLOCK_SIZE = 4096;
+
+struct DriftOptions {
+        std::vector<unsigned int> sampleRates = {44100, 48000, 96000};
+        double seconds = 3600.0;
+};
+
+struct GateEvent {
+        uint64_t position;
+        bool open;
+};
+
+struct DriftResult {
+        uint64_t events = 0;
+        uint64_t wrongEvents = 0;
+        // The first wrong event and the expected one.
+        GateEvent found = {};
+        GateEvent expected = {};
+};
+
+/**
+ * Returns the samples of a time in ms rounded up, like the gate.
+ */
+uint64_t msToSamples(uint64_t ms, unsigned int sampleRate)
+{
+        return (ms * sampleRate + 999) / 1000;
+}
+
+/**
+ * Returns the expected position of each event of the gate.
+ */
+class GateSchedule {
+ public:
+        explicit GateSchedule(unsigned int sampleRate)
+                : intervalSamples{msToSamples(GATE_INTERVAL_MS, sampleRate)}
+                , durationSamples{msToSamples(GATE_DURATION_MS, sampleRate)}
+                // The gate starts closed for the default minimum duration
+                // and the first interval is the default minimum interval,
+                // they were drawn before the parameters were set.
+                , nextEvent{msToSamples(static_cast<uint64_t>(ENT_RGATE_DEFAULT_MIN_DURATION),
+                                        sampleRate), true}
+                , openSamples{msToSamples(static_cast<uint64_t>(ENT_RGATE_DEFAULT_MIN_INTERVAL),
+                                          sampleRate)}
+        {
+        }
+
+        GateEvent next()
+        {
+                auto event = nextEvent;
+                if (event.open) {
+                        // The gate closes on the last sample of the interval.
+                        nextEvent = {event.position + openSamples - 1, false};
+                        openSamples = intervalSamples;
+                } else {
+                        // The gate is closed on its sample and the duration.
+                        nextEvent = {event.position + 1 + durationSamples, true};
+                }
+                return event;
+        }
+
+ private:
+        uint64_t intervalSamples;
+        uint64_t durationSamples;
+        GateEvent nextEvent;
+        uint64_t openSamples;
+};
+
+DriftResult runDrift(unsigned int sampleRate, uint64_t frames)
+{
+        std::unique_ptr<struct ent_rgate, void(*)(struct ent_rgate*)>
+                rgate(ent_rgate_create(sampleRate), [](struct ent_rgate *g) { ent_rgate_free(&g); });
+        ent_rgate_enable(rgate.get(), true);
+        ent_rgate_set_min_interval(rgate.get(), GATE_INTERVAL_MS);
+        ent_rgate_set_max_interval(rgate.get(), GATE_INTERVAL_MS);
+        ent_rgate_set_min_duration(rgate.get(), GATE_DURATION_MS);
+        ent_rgate_set_max_duration(rgate.get(), GATE_DURATION_MS);
+        ent_rgate_set_min_gain(rgate.get(), 0.0f);
+        ent_rgate_set_max_gain(rgate.get(), 0.0f);
+        ent_rgate_set_randomness(rgate.get(), 1.0f);
+
+        // The input is 1, the output is the gain of the gate.
+        std::vector<float> input(MAX_BLOCK_SIZE, 1.0f);
+        std::vector<float> outputLeft(MAX_BLOCK_SIZE);
+        std::vector<float> outputRight(MAX_BLOCK_SIZE);
+        float *in[2] = {input.data(), input.data()};
+        float *out[2] = {outputLeft.data(), outputRight.data()};
+
+        std::minstd_rand random(sampleRate);
+        std::uniform_int_distribution<size_t> blockSizes(1, MAX_BLOCK_SIZE);
+
+        DriftResult result;
+        GateSchedule schedule(sampleRate);
+        auto expected = schedule.next();
+        // An event starts a ramp after a constant gain. The ramps are
+        // shorter than the states, the gain is constant before each event.
+        float previousGain = 0.0f;
+        bool constant = true;
+        for (uint64_t position = 0; position < frames;) {
+                auto size = static_cast<size_t>(std::min<uint64_t>(blockSizes(random),
+                                                                   frames - position));
+                std::fill_n(outputLeft.begin(), size, 0.0f);
+                std::fill_n(outputRight.begin(), size, 0.0f);
+                ent_rgate_process(rgate.get(), in, out, size);
+
+                for (size_t i = 0; i < size; i++, position++) {
+                        auto gain = outputLeft[i];
+                        if (gain == previousGain) {
+                                constant = true;
+                                continue;
+                        }
+
+                        if (constant) {
+                                GateEvent found = {position, gain > previousGain};
+                                if ((found.position != expected.position
+                                     || found.open != expected.open)
+                                    && result.wrongEvents++ == 0) {
+                                        result.found = found;
+                                        result.expected = expected;
+                                }
+                                // Skips the expected events before the found one,
+                                // a missed event is counted once.
+                                while (expected.position <= found.position)
+                                        expected = schedule.next();
+                                result.events++;
+                        }
+                        previousGain = gain;
+                        constant = false;
+                }
+        }
+
+        // The expected events that weren't found.
+        while (expected.position < frames) {
+                if (result.wrongEvents++ == 0) {
+                        result.found = {frames, expected.open};
+                        result.expected = expected;
+                }
+                expected = schedule.next();
+        }
+
+        return result;
+}
+
+void printUsage(const char *name)
+{
+        std::cout << "Usage: " << name << " [options]\n"
+                  << "Check that the random gate events land on their expected samples\n"
+                  << "over long renders. Returns 1 if an event has drifted.\n\n"
+                  << "Options:\n"
+                  << "  -r, --sample-rate <rate>  check only the given sample rate\n"
+                  << "  -s, --seconds <seconds>   rendered audio time (default 3600)\n"
+                  << "  -h, --help                show this help\n";
+}
+
+bool parseOptions(int argc, char *argv[], DriftOptions &options)
+{
+        try {
+                for (int i = 1; i < argc; i++) {
+                        std::string arg = argv[i];
+                        auto isOption = [&arg](const char *shortName, const char *longName) {
+                                return arg == shortName || arg == longName;
+                        };
+
+                        if (isOption("-h", "--help"))
+                                return false;
+
+                        if (i + 1 >= argc) {
+                                std::cerr << "missing value for " << arg << "\n";
+                                return false;
+                        }
+
+                        std::string value = argv[++i];
+                        if (isOption("-r", "--sample-rate")) {
+                                options.sampleRates = {static_cast<unsigned int>(std::stoul(value))};
+                        } else if (isOption("-s", "--seconds")) {
+                                options.seconds = std::stod(value);
+                        } else {
+                                std::cerr << "unknown option " << arg << "\n";
+                                return false;
+                        }
+                }
+        } catch (const std::exception &) {
+                std::cerr << "invalid option value\n";
+                return false;
+        }
+
+        for (auto sampleRate : options.sampleRates) {
+                if (sampleRate < 1) {
+                        std::cerr << "invalid sample rate " << sampleRate << "\n";
+                        return false;
+                }
+        }
+
+        if (options.seconds <= 0.0) {
+                std::cerr << "invalid duration\n";
+                return false;
+        }
+
+        return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+        DriftOptions options;
+        if (!parseOptions(argc, argv, options)) {
+                printUsage(argv[0]);
+                return 1;
+        }
+
+        bool drifted = false;
+        for (auto sampleRate : options.sampleRates) {
+                auto frames = static_cast<uint64_t>(options.seconds * sampleRate);
+                auto res = runDrift(sampleRate, frames);
+                std::cout << "rate " << sampleRate << ": " << res.events << " events in "
+                          << frames << " samples, " << res.wrongEvents << " wrong";
+                if (res.wrongEvents > 0) {
+                        drifted = true;
+                        std::cout << ", first " << (res.found.open ? "open" : "close")
+                                  << " at " << res.found.position << ", expected "
+                                  << (res.expected.open ? "open" : "close")
+                                  << " at " << res.expected.position;
+                }
+                std::cout << "\n";
+        }
+
+        return drifted ? 1 : 0;
+}
@@ -0,0 +1,134 @@
+/**
+ * File name: WavWriter.cpp
+ * Project: Entropictron (A texture synthesizer)
+ *
+ * Copyright (C) 2026 Iurie Nistor
+ *
+ * This file is part of Entropictron.
+ *
+ * Entropictron is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "WavWriter.h"
+
+#include <cstdint>
+
+namespace {
+
+constexpr uint16_t wavFormatIeeeFloat = 3;
+constexpr uint16_t wavChannels = 2;
+constexpr uint16_t wavBitsPerSample = 32;
+constexpr size_t wavHeaderSize = 44;
+
+void putLe16(std::ofstream &stream, uint16_t val)
+{
+        char b[2] = {static_cast<char>(val & 0xff),
+                     static_cast<char>((val >> 8) & 0xff)};
+        stream.write(b, sizeof(b));
+}
+
+void putLe32(std::ofstream &stream, uint32_t val)
+{
+        char b[4] = {static_cast<char>(val & 0xff),
+                     static_cast<char>((val >> 8) & 0xff),
+                     static_cast<char>((val >> 16) & 0xff),
+                     static_cast<char>((val >> 24) & 0xff)};
+        stream.write(b, sizeof(b));
+}
+
+} // namespace
+
+WavWriter::WavWriter(Format format, unsigned int sampleRate)
+        : outputFormat{format}
+        , outputSampleRate{sampleRate}
+        , framesWritten{0}
+{
+}
+
+WavWriter::~WavWriter()
+{
+        close();
+}
+
+bool WavWriter::open(const std::filesystem::path &path)
+{
+        stream.open(path, std::ios::binary | std::ios::trunc);
+        if (!stream.is_open())
+                return false;
+
+        framesWritten = 0;
+
+        // Write a placeholder header, the sizes are updated on close.
+        if (outputFormat == Format::Wav)
+                return writeHeader();
+
+        return true;
+}
+
+bool WavWriter::write(const float *left, const float *right, size_t frames)
+{
+        if (!stream.is_open())
+                return false;
+
+        interleaved.resize(2 * frames);
+        for (size_t i = 0; i < frames; i++) {
+                interleaved[2 * i]     = left[i];
+                interleaved[2 * i + 1] = right[i];
+        }
+
+        stream.write(reinterpret_cast<const char*>(interleaved.data()),
+                     interleaved.size() * sizeof(float));
+        framesWritten += frames;
+        return stream.good();
+}
+
+bool WavWriter::close()
+{
+        if (!stream.is_open())
+                return true;
+
+        bool res = true;
+        if (outputFormat == Format::Wav) {
+                stream.seekp(0);
+                res = writeHeader();
+        }
+
+        stream.close();
+        return res;
+}
+
+bool WavWriter::writeHeader()
+{
+        const uint32_t blockAlign = wavChannels * wavBitsPerSample / 8;
+        const uint32_t dataSize = framesWritten * blockAlign;
+
+        stream.write("RIFF", 4);
+        putLe32(stream, wavHeaderSize - 8 + dataSize);
+        stream.write("WAVE", 4);
+
+        stream.write("fmt ", 4);
+        putLe32(stream, 16);
+        putLe16(stream, wavFormatIeeeFloat);
+        putLe16(stream, wavChannels);
+        putLe32(stream, outputSampleRate);
+        putLe32(stream, outputSampleRate * blockAlign);
+        putLe16(stream, blockAlign);
+        putLe16(stream, wavBitsPerSample);
+
+        stream.write("data", 4);
+        putLe32(stream, dataSize);
+
+        return stream.good();
+}
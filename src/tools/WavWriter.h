@@ -1,5 +1,5 @@
 /**
- * File name: DspFrameTimer.h
+ * File name: WavWriter.h
  * Project: Entropictron (A texture synthesizer)
  *
  * Copyright (C) 2026 Iurie Nistor
@@ -21,25 +21,39 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
  */
 
-#ifndef ENT_DSP_FRAME_TIMER_H
-#define ENT_DSP_FRAME_TIMER_H
+#ifndef ENT_WAV_WRITER_H
+#define ENT_WAV_WRITER_H
 
-#include "globals.h"
-#include "DspTypes.h"
+#include <filesystem>
+#include <fstream>
+#include <vector>
 
-class DspFrameTimer {
-public:
-    explicit DspFrameTimer(int timeout = ENT_DEFAULT_SAMPLE_RATE * 0.05);
-    void setTimeout(int frames);
-    int getTimeout() const;
-    void setOnTimeoutCallback(std::function<void(size_t)> callback);
-    void reset();
-    void process(size_t size);
+/**
+ * Writes interleaved stereo 32-bit float audio either as
+ * a WAV file (IEEE float) or as headerless raw float data.
+ */
+class WavWriter {
+ public:
+        enum class Format : int {
+                Wav,
+                Raw
+        };
+
+        WavWriter(Format format, unsigned int sampleRate);
+        ~WavWriter();
+        bool open(const std::filesystem::path &path);
+        bool write(const float *left, const float *right, size_t frames);
+        bool close();
+
+ protected:
+        bool writeHeader();
 
-private:
-    std::function<void(size_t)> timeoutCallback;
-    int timerTimeoutFrames;
-    int timerFramesLeft;
+ private:
+        Format outputFormat;
+        unsigned int outputSampleRate;
+        std::ofstream stream;
+        std::vector<float> interleaved;
+        size_t framesWritten;
 };
 
-#endif // ENT_DSP_FRAME_TIMER_H
+#endif // ENT_WAV_WRITER_H